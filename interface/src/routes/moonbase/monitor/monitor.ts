@@ -97,6 +97,10 @@ export function clearColors() {
   colors = [];
 }
 
+export function clearVertices() {
+  vertices.length = 0;
+}
+
 export const updateScene = (vertices: number[], colors: number[]) => {
   if (!gl) return; 
 
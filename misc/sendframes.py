@@ -0,0 +1,136 @@
+"""
+    @title     MoonBase
+    @file      sendframes.py
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/moonbase/module/artnetin/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+
+    Test sender for the Artnet In module: sends Art-Net, E1.31 or DDP frames (a moving rainbow) at a fixed fps.
+    With --receive it counts the packets, frames and lost packets it receives instead (e.g. to benchmark on Linux via loopback):
+
+        python3 misc/sendframes.py --receive --protocol ddp &
+        python3 misc/sendframes.py --protocol ddp --lights 4000 --fps 100
+"""
+
+import argparse
+import socket
+import struct
+import time
+import uuid
+
+ARTNET_PORT, E131_PORT, DDP_PORT = 6454, 5568, 4048
+CID = uuid.uuid4().bytes
+
+
+def artnet_packets(data, universe_size, sequence, sync):
+    for universe, offset in enumerate(range(0, len(data), universe_size)):
+        channels = data[offset:offset + universe_size]
+        if len(channels) % 2: channels += b"\0" #Art-Net: even length
+        yield b"Art-Net\0" + struct.pack("<H", 0x5000) + struct.pack(">H", 14) + bytes([sequence % 255 + 1, 0]) + struct.pack("<H", universe) + struct.pack(">H", len(channels)) + channels
+    if sync:
+        yield b"Art-Net\0" + struct.pack("<H", 0x5200) + struct.pack(">H", 14) + b"\0\0"
+
+
+def e131_packets(data, universe_size, sequence, sync):
+    for universe, offset in enumerate(range(0, len(data), universe_size), 1):
+        channels = data[offset:offset + universe_size]
+        n = len(channels) + 1 #start code
+        root = struct.pack(">HH", 0x0010, 0) + b"ASC-E1.17\0\0\0" + struct.pack(">HI", 0x7000 | (110 + n), 4) + CID
+        framing = struct.pack(">HI", 0x7000 | (88 + n), 2) + b"sendframes.py".ljust(64, b"\0") + bytes([100]) + struct.pack(">H", 1 if sync else 0) + bytes([sequence % 256, 0]) + struct.pack(">H", universe)
+        dmp = struct.pack(">H", 0x7000 | (10 + n)) + bytes([2, 0xA1]) + struct.pack(">HHH", 0, 1, n) + b"\0" + channels
+        yield root + framing + dmp
+    if sync:
+        yield struct.pack(">HH", 0x0010, 0) + b"ASC-E1.17\0\0\0" + struct.pack(">HI", 0x7000 | 33, 8) + CID + struct.pack(">HIBHH", 0x7000 | 11, 1, sequence % 256, 1, 0)
+
+
+def ddp_packets(data, universe_size, sequence, sync):
+    size = 1440
+    for offset in range(0, len(data), size):
+        channels = data[offset:offset + size]
+        push = 0x01 if offset + size >= len(data) else 0
+        yield bytes([0x40 | push, sequence % 15 + 1, 0x0B, 1]) + struct.pack(">IH", offset, len(channels)) + channels
+
+
+def send(args):
+    packets = {"artnet": artnet_packets, "e131": e131_packets, "ddp": ddp_packets}[args.protocol]
+    port = {"artnet": ARTNET_PORT, "e131": E131_PORT, "ddp": DDP_PORT}[args.protocol]
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    interval = 1 / args.fps
+    start = next_frame = time.perf_counter()
+    sequence = sent = 0
+    while args.frames == 0 or sequence < args.frames:
+        shift = sequence * 4
+        data = bytearray()
+        for light in range(args.lights):
+            hue = (light * 256 // max(args.lights, 1) + shift) % 256
+            data += bytes([255 - hue, hue, (hue * 2) % 256])
+        for packet in packets(bytes(data), args.universe_size, sequence, args.sync):
+            sock.sendto(packet, (args.ip, port))
+            sent += 1
+        sequence += 1
+        next_frame += interval
+        time.sleep(max(0, next_frame - time.perf_counter()))
+        if sequence % args.fps == 0:
+            elapsed = time.perf_counter() - start
+            print(f"{sequence / elapsed:.1f} frames/s, {sent / elapsed:.0f} packets/s")
+
+
+def receive(args):
+    port = {"artnet": ARTNET_PORT, "e131": E131_PORT, "ddp": DDP_PORT}[args.protocol]
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", port))
+    sock.settimeout(1)
+    sequences = {}
+    packets = frames = lost = 0
+    last = time.perf_counter()
+    while True:
+        try:
+            data = sock.recv(1500)
+        except socket.timeout:
+            data = b""
+        if data:
+            packets += 1
+            key = sequence = frame_end = None
+            if args.protocol == "artnet" and data[:8] == b"Art-Net\0":
+                opcode = struct.unpack("<H", data[8:10])[0]
+                if opcode == 0x5000: key, sequence, size = struct.unpack("<H", data[14:16])[0], data[12] - 1, 255
+                frame_end = opcode == 0x5200
+            elif args.protocol == "e131" and data[4:16] == b"ASC-E1.17\0\0\0":
+                if data[21] == 0x04: key, sequence, size = struct.unpack(">H", data[113:115])[0], data[111], 256
+                frame_end = data[21] == 0x08
+            elif args.protocol == "ddp":
+                key, sequence, size = struct.unpack(">I", data[4:8])[0], (data[1] & 0x0F) - 1, 15
+                frame_end = data[0] & 0x01
+            if key is not None and sequence >= 0:
+                if key in sequences:
+                    gap = (sequence - sequences[key]) % size
+                    if 1 < gap < size // 2: lost += gap - 1
+                sequences[key] = sequence
+            if frame_end: frames += 1
+        now = time.perf_counter()
+        if now - last >= 1:
+            print(f"{packets} packets/s, {frames} frames/s, {lost} lost")
+            packets = frames = lost = 0
+            last = now
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Art-Net / E1.31 / DDP test sender and receiver")
+    parser.add_argument("--ip", default="127.0.0.1", help="destination (e.g. the IP of the board)")
+    parser.add_argument("--protocol", choices=["artnet", "e131", "ddp"], default="artnet")
+    parser.add_argument("--lights", type=int, default=512, help="RGB lights per frame")
+    parser.add_argument("--universe-size", type=int, default=510, help="channels per universe (Art-Net, E1.31)")
+    parser.add_argument("--fps", type=int, default=40)
+    parser.add_argument("--frames", type=int, default=0, help="0: until stopped")
+    parser.add_argument("--sync", action="store_true", help="send ArtSync / E1.31 sync after each frame")
+    parser.add_argument("--receive", action="store_true", help="count received packets, frames and lost packets")
+    args = parser.parse_args()
+    try:
+        receive(args) if args.receive else send(args)
+    except KeyboardInterrupt:
+        pass
@@ -13,11 +13,6 @@
 
 #include <Arduino.h>
 #include "ArduinoJson.h"
-// struct Coord3D16 {
-//     uint16_t x;
-//     uint16_t y;
-//     uint16_t z;
-// };
 
 struct Coord3D {
     int x;
@@ -52,6 +47,17 @@ struct Coord3D {
     }
 };
 
+//compact Coord3D (6 instead of 12 bytes) to store positions, e.g. the layout
+struct Coord3D16 {
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+
+    operator Coord3D() const {
+        return Coord3D{x, y, z};
+    }
+};
+
   
 //convenience function to compare two char strings
 static bool equal(const char *a, const char *b) {
@@ -68,6 +74,20 @@ static bool contains(const char *a, const char *b) {
     return strnstr(a, b, sizeof(a)) != nullptr;
 }
 
+//FNV-1a hash, continue with the result to hash more data
+static uint32_t hash32(const void *data, size_t length, uint32_t hash = 2166136261) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 16777619;
+    }
+    return hash;
+}
+
+//FNV-1a hash of a zero terminated string, as hash32, also at compile time
+constexpr uint32_t hashString(const char *s, uint32_t hash = 2166136261) {
+    return *s ? hashString(s + 1, (hash ^ (uint8_t)*s) * 16777619) : hash;
+}
+
 
 //See https://discord.com/channels/473448917040758787/718943978636050542/1357670679196991629
 template <size_t N>
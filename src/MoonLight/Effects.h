@@ -32,8 +32,8 @@ class SolidEffect: public Node {
 //each needs 12 bytes
 struct Ball {
   unsigned long lastBounceTime;
-  float impactVelocity;
-  float height;
+  q16_16 impactVelocity;
+  q16_16 height;
 };
 
 class BouncingBallsEffect: public Node {
@@ -41,16 +41,20 @@ class BouncingBallsEffect: public Node {
 
   uint8_t grav = 128;
   uint8_t numBalls = 8;
+  char palette[16] = "Party";
+  PaletteLUT lut;
 
   void addControls(JsonArray controls) override {
     addControl(controls, &grav, "grav", "range", 128);
     addControl(controls, &numBalls, "numBalls", "range", 8, 1, maxNumBalls);
+    addPaletteControl(controls, palette);
     ESP_LOGD(TAG, "");
     serializeJson(controls, Serial); Serial.println();
   }
 
   //binding of loop persistent values (pointers)
-  Ball balls[16][maxNumBalls];
+  Ball *balls = nullptr; //maxNumBalls per row, in the arena
+  uint16_t rows = 0;
 
   const char * name() override {return "BouncingBalls";}
   uint8_t dim() override {return _1D;}
@@ -60,7 +64,7 @@ class BouncingBallsEffect: public Node {
     layerV->fadeToBlackBy(100);
 
     // non-chosen color is a random color
-    const float gravity = -9.81f; // standard value of gravity
+    const q16_16 gravity = Q16_16(-9.81f); // standard value of gravity
     // const bool hasCol2 = SEGCOLOR(2);
     const unsigned long time = millis();
 
@@ -69,24 +73,34 @@ class BouncingBallsEffect: public Node {
     //   for (size_t i = 0; i < maxNumBalls; i++) balls[i].lastBounceTime = time;
     // }
 
-    for (int y =0; MIN(y<layerV->size.y,16); y++) { //Min for the time being
+    //balls for each row, sized to the layout
+    if (rows != layerV->size.y) {
+      rows = layerV->size.y;
+      balls = arena.reserve(rows * maxNumBalls * sizeof(Ball))?arena.alloc<Ball>(rows * maxNumBalls):nullptr;
+    }
+    if (!balls || !lut.update(findPalette(palette))) return;
+
+    LedsWriter lights = layerV->writer<CRGB>();
+
+    for (int y = 0; y < rows; y++) {
     for (size_t i = 0; i < numBalls; i++) {
-      float timeSinceLastBounce = (time - balls[y][i].lastBounceTime)/((255-grav)/64 + 1);
-      float timeSec = timeSinceLastBounce/1000.0f;
-      balls[y][i].height = (0.5f * gravity * timeSec + balls[y][i].impactVelocity) * timeSec; // avoid use pow(x, 2) - its extremely slow !
+      Ball &ball = balls[y * maxNumBalls + i];
+      uint32_t timeSinceLastBounce = MIN((time - ball.lastBounceTime)/((255-grav)/64 + 1), 60000); //a minute: on the ground anyway, no overflow
+      q16_16 timeSec = (timeSinceLastBounce << 16) / 1000;
+      ball.height = mulQ16_16(mulQ16_16(gravity / 2, timeSec) + ball.impactVelocity, timeSec); // avoid use pow(x, 2) - its extremely slow !
 
-      if (balls[y][i].height <= 0.0f) {
-        balls[y][i].height = 0.0f;
+      if (ball.height <= 0) {
+        ball.height = 0;
         //damping for better effect using multiple balls
-        float dampening = 0.9f - float(i)/float(numBalls * numBalls); // avoid use pow(x, 2) - its extremely slow !
-        balls[y][i].impactVelocity = dampening * balls[y][i].impactVelocity;
-        balls[y][i].lastBounceTime = time;
+        q16_16 dampening = Q16_16(0.9f) - (i << 16) / (numBalls * numBalls); // avoid use pow(x, 2) - its extremely slow !
+        ball.impactVelocity = mulQ16_16(dampening, ball.impactVelocity);
+        ball.lastBounceTime = time;
 
-        if (balls[y][i].impactVelocity < 0.015f) {
-          float impactVelocityStart = sqrtf(-2.0f * gravity) * random8(5,11)/10.0f; // randomize impact velocity
-          balls[y][i].impactVelocity = impactVelocityStart;
+        if (ball.impactVelocity < Q16_16(0.015f)) {
+          q16_16 impactVelocityStart = Q16_16(4.4294469f) * random8(5,11) / 10; // sqrtf(-2.0f * gravity), randomize impact velocity
+          ball.impactVelocity = impactVelocityStart;
         }
-      } else if (balls[y][i].height > 1.0f) {
+      } else if (ball.height > Q16_16(1.0f)) {
         continue; // do not draw OOB ball
       }
 
@@ -98,13 +112,9 @@ class BouncingBallsEffect: public Node {
       //   color = SEGCOLOR(i % NUM_COLORS);
       // }
 
-      int pos = roundf(balls[y][i].height * (layerV->size.x - 1));
+      int pos = ((int64_t)ball.height * (layerV->size.x - 1) + 32768) >> 16; //rounded
 
-      CRGBPalette16 palette = PartyColors_p;
-
-      CRGB color = ColorFromPalette(palette, i*(256/max(numBalls, (uint8_t)8))); //error: no matching function for call to 'max(uint8_t&, int)'
-
-      layerV->setLight({pos, y, 0}, color);
+      lights.set({pos, y, 0}, lut[i*(256/max(numBalls, (uint8_t)8))]); //error: no matching function for call to 'max(uint8_t&, int)'
       // if (layerV->size.x<32) layerV->setPixelColor(indexToVStrip(pos, stripNr), color); // encode virtual strip into index
       // else           layerV->setPixelColor(balls[i].height + (stripNr+1)*10.0f, color);
     } //balls      layerV->fill_solid(CRGB::White);
@@ -154,11 +164,14 @@ public:
   uint8_t xFrequency = 64;
   uint8_t fadeRate = 128;
   uint8_t speed = 128;
+  char palette[16] = "Party";
+  PaletteLUT lut;
 
   void addControls(JsonArray controls) override {
     addControl(controls, &xFrequency, "xFrequency", "range", 64);
     addControl(controls, &fadeRate, "fadeRate", "range", 128);
     addControl(controls, &speed, "speed", "range", 128);
+    addPaletteControl(controls, palette);
   }
 
   const char * name() override {return "Lissajous";}
@@ -168,19 +181,21 @@ public:
   void setup() override {}
 
   void loop() override {
-    CRGBPalette16 palette = PartyColors_p;
+    if (!lut.update(findPalette(palette))) return;
 
     layerV->fadeToBlackBy(fadeRate);
     uint_fast16_t phase = millis() * speed / 256;  // allow user to control rotation speed, speed between 0 and 255!
     Coord3D locn = {0,0,0};
+    uint8_t colorIndex = millis()/100;
+    LedsWriter lights = layerV->writer<CRGB>();
     for (int i=0; i < 256; i ++) {
-        //WLEDMM: stick to the original calculations of xlocn and ylocn
-        locn.x = sin8(phase/2 + (i*xFrequency)/64);
-        locn.y = cos8(phase/2 + i*2);
-        locn.x = (layerV->size.x < 2) ? 1 : (::map(2*locn.x, 0,511, 0,2*(layerV->size.x-1)) +1) /2;    // softhack007: "*2 +1" for proper rounding
-        locn.y = (layerV->size.y < 2) ? 1 : (::map(2*locn.y, 0,511, 0,2*(layerV->size.y-1)) +1) /2;    // "layerV->size.y > 2" is needed to avoid div/0 in map()
+        //WLEDMM: stick to the original 8 bit angles of xlocn and ylocn, scaled to 0..size-1 with rounding as softhack007's map, without a division per light
+        uint8_t angleX = phase/2 + (i*xFrequency)/64;
+        uint8_t angleY = phase/2 + i*2;
+        locn.x = ((layerV->size.x - 1) * (32768 + sinQ15(angleX << 8)) + 32768) >> 16;
+        locn.y = ((layerV->size.y - 1) * (32768 + cosQ15(angleY << 8)) + 32768) >> 16;
         // layerV->setLightColor(locn, ColorFromPalette(palette, millis()/100+i, 255));
-        layerV->setLight(locn, ColorFromPalette(palette, millis()/100+i, 255));
+        lights.set(locn, lut[colorIndex + i]);
     }
   }
 };
@@ -199,13 +214,13 @@ class MovingHeadEffect: public Node {
   }
 
   void loop() override {
+    MovingHeadWriter movingHeads = layerV->writer<MovingHead>();
+    int pos = millis()*bpm/6000 % layerV->size.x; //beatsin16( bpm, 0, layerV->size.x-1);
+    CRGB color = CHSV( millis()/50, 255, 255);
     for (int i=0; i<layerV->size.x; i++) {
 
       MovingHead mh;
 
-      int pos = millis()*bpm/6000 % layerV->size.x; //beatsin16( bpm, 0, layerV->size.x-1);
-      CRGB color = CHSV( millis()/50, 255, 255);
-
       if (i == pos) {
         mh.red = color.red;
         mh.green = color.green;
@@ -226,7 +241,7 @@ class MovingHeadEffect: public Node {
       mh.dimmer = layerV->layerP->lights.header.brightness;
       mh.strobe = 0;
 
-      layerV->setLight({i,0,0}, mh);
+      movingHeads.set(i, mh);
     }
   }
 };
@@ -267,7 +282,12 @@ class RipplesEffect: public Node {
   uint8_t speed;
   uint8_t interval;
 
+  q16_16 angleStep; //ripple angle per unit of distance
+  uint16_t timeAngle;
+  const uint16_t *distances; //distance to the center per light, see VirtualLayer::distanceField
+
   void addControls(JsonArray controls) override {
+    hasSlices = true;
     addControl(controls, &speed, "speed", "range", 50);
     addControl(controls, &interval, "interval", "range", 128);
   }
@@ -275,18 +295,26 @@ class RipplesEffect: public Node {
   void loop() override {
 
     float ripple_interval = 1.3f * ((255.0f - interval)/128.0f) * sqrtf(layerV->size.y);
-    float time_interval = millis()/(100.0 - speed)/((256.0f-128.0f)/20.0f);
+    // sinf(d/ripple_interval + time_interval) as angles: time_interval = millis()/(100.0 - speed)/((256.0f-128.0f)/20.0f) and d from the distance field
+    angleStep = MIN(layerV->size.y / 9.899495f / FIELD_DISTANCE_SCALE / ripple_interval * ANGLE_PER_RADIAN * 65536, 2e9f);
+    timeAngle = speed != 100? (int64_t)millis() * 6519 / (4 * (100 - speed)): 0; //ANGLE_PER_RADIAN / 6.4 = 6519 / 4
+    distances = layerV->distanceField(); //here as loopSlice runs on both cores
 
     layerV->fadeToBlackBy(255);
+  }
 
+  void loopSlice(uint8_t slice, uint8_t nrOfSlices) override {
     Coord3D pos = {0,0,0};
+    LedsWriter lights = layerV->writer<CRGB>();
+    const int height = layerV->size.y;
     for (pos.z=0; pos.z<layerV->size.z; pos.z++) {
-      for (pos.x=0; pos.x<layerV->size.x; pos.x++) {
+      for (pos.x=sliceStart(layerV->size.x, slice, nrOfSlices); pos.x<sliceStart(layerV->size.x, slice + 1, nrOfSlices); pos.x++) {
 
-        float d = distance(layerV->size.x/2.0f, layerV->size.z/2.0f, 0.0f, (float)pos.x, (float)pos.z, 0.0f) / 9.899495f * layerV->size.y;
-        pos.y = floor(layerV->size.y/2.0f * (1 + sinf(d/ripple_interval + time_interval))); //between 0 and layerV->size.y
+        pos.y = height / 2; //distance in the x,z plane through the center
+        uint16_t angle = (uint16_t)(((int64_t)distances[layerV->XYZUnprojected(pos)] * angleStep) >> 16) + timeAngle;
+        pos.y = (height * (32768 + sinQ15(angle))) >> 16; //floor(height/2 * (1 + sin)), between 0 and height - 1
 
-        layerV->setLight(pos, CHSV( millis()/50 + random8(64), 200, 255));
+        lights.set(pos, CHSV( millis()/50 + random8(64), 200, 255));
       }
     }
   }
@@ -311,9 +339,9 @@ class RGBWParEffect: public Node {
 
   void loop() override {
     layerV->fadeToBlackBy(255); //reset all channels
-    for (int i=0; i<layerV->size.x * layerV->layerP->lights.header.channelsPerLight; i++) {
-      layerV->layerP->lights.leds[i] = CRGB::Black;
-    }
+    LedsRGBWWriter pars = layerV->writer<CRGBW>();
+    CRGBW black = {0, 0, 0, 0};
+    pars.fill(0, black, layerV->size.x);
 
     int pos = millis()*bpm/6000 % layerV->size.x; //beatsin16( bpm, 0, layerV->size.x-1);
 
@@ -322,7 +350,7 @@ class RGBWParEffect: public Node {
     rgbw.green = green;
     rgbw.blue = blue;
     rgbw.white = white;
-    layerV->setLight({pos,0,0}, rgbw);
+    pars.set(pos, rgbw);
   }
 };
   
@@ -356,7 +384,13 @@ class SinusEffect: public Node {
 
   uint8_t speed = 5;
 
+  uint8_t hueOffset;
+  uint16_t phase = 0; // Tracks the phase of the sine wave
+  uint16_t framePhase;
+  CRGB *hueColors = nullptr; //CHSV(hue, 255, 255) per hue, in the arena
+
   void addControls(JsonArray controls) override {
+    hasSlices = true;
     addControl(controls, &speed, "speed", "range", 5);
   }
 
@@ -367,22 +401,43 @@ class SinusEffect: public Node {
   void loop() override {
     layerV->fadeToBlackBy(70);
 
-    uint8_t hueOffset =  millis() / 10;
-    static uint16_t phase = 0; // Tracks the phase of the sine wave
-    uint8_t brightness = 255;
-    
-    for (uint16_t i = 0; i < layerV->nrOfLights; i++) {
-        // Calculate the sine wave value for the current LED
-        uint8_t wave = sin8((i * 255 / layerV->nrOfLights) + phase);
-        // Map the sine wave value to a color hue
-        uint8_t hue = wave + hueOffset;
-        // Set the LED color using the calculated hue
-        layerV->setLightColor(i, CHSV(hue, 255, brightness));
+    if (!hueColors) {
+      hueColors = arena.reserve(256 * sizeof(CRGB))?arena.alloc<CRGB>(256):nullptr;
+      if (hueColors) hueTable(hueColors, 255, 255);
     }
 
+    hueOffset =  millis() / 10;
+    framePhase = phase;
+
     // Increment the phase to animate the wave
     phase += speed;
   }
+
+  void loopSlice(uint8_t slice, uint8_t nrOfSlices) override {
+    if (!hueColors) return;
+
+    LedsWriter lights = layerV->writer<CRGB>();
+    const uint16_t nrOfLights = layerV->nrOfLights;
+    const uint16_t end = sliceStart(nrOfLights, slice + 1, nrOfSlices);
+    uint16_t i = sliceStart(nrOfLights, slice, nrOfSlices);
+    // i * 255 / nrOfLights, counted up without a division per light
+    uint32_t waveIndex = (uint32_t)i * 255 / nrOfLights;
+    uint32_t remainder = (uint32_t)i * 255 % nrOfLights;
+    uint8_t hues[64];
+    CRGB colors[64];
+    while (i < end) {
+      uint16_t count = MIN(end - i, 64);
+      for (uint16_t j = 0; j < count; j++) {
+        // Calculate the sine wave value for the current LED and map it to a color hue
+        hues[j] = sin8(waveIndex + framePhase) + hueOffset;
+        for (remainder += 255; remainder >= nrOfLights; remainder -= nrOfLights) waveIndex++;
+      }
+      // Set the LED colors using the calculated hues
+      hsv2rgbSpan(hueColors, hues, colors, count);
+      lights.setSpan(i, colors, count);
+      i += count;
+    }
+  }
 };
 
 class SphereMoveEffect: public Node {
@@ -391,8 +446,12 @@ class SphereMoveEffect: public Node {
   const char * tags() override {return "💫";}
 
   uint8_t speed;
+
+  Coord3D origin;
+  float diameter;
   
   void addControls(JsonArray controls) override {
+    hasSlices = true;
     addControl(controls, &speed, "speed", "range", 50, 0, 99);
   }
 
@@ -400,27 +459,22 @@ class SphereMoveEffect: public Node {
 
     layerV->fadeToBlackBy(255);
 
-    float time_interval = millis()/(100 - speed)/((256.0f-128.0f)/20.0f);
-
-    Coord3D origin;
-    origin.x = layerV->size.x / 2.0 * ( 1.0 + sinf(time_interval));
-    origin.y = layerV->size.y / 2.0 * ( 1.0 + cosf(time_interval));
-    origin.z = layerV->size.z / 2.0 * ( 1.0 + cosf(time_interval));
+    //time_interval = millis()/(100 - speed)/((256.0f-128.0f)/20.0f) as angle, ANGLE_PER_RADIAN / 6.4 = 6519 / 4
+    uint64_t timeAngle = (uint64_t)millis() * 6519 / (4 * (100 - speed));
 
-    float diameter = 2.0f+sinf(time_interval/3.0f);
+    origin.x = (layerV->size.x * (32768 + sinQ15(timeAngle))) >> 16;
+    origin.y = (layerV->size.y * (32768 + cosQ15(timeAngle))) >> 16;
+    origin.z = (layerV->size.z * (32768 + cosQ15(timeAngle))) >> 16;
 
-    Coord3D pos;
-    for (pos.x=0; pos.x<layerV->size.x; pos.x++) {
-        for (pos.y=0; pos.y<layerV->size.y; pos.y++) {
-            for (pos.z=0; pos.z<layerV->size.z; pos.z++) {
-                float d = distance(pos.x, pos.y, pos.z, origin.x, origin.y, origin.z);
+    diameter = 2.0f + sinQ15(timeAngle / 3) / 32767.0f;
+  }
 
-                if (d>diameter && d<diameter + 1.0) {
-                  layerV->setLight(pos, CHSV( millis()/50 + random8(64), 200, 255));
-                }
-            }
-        }
-    }
+  void loopSlice(uint8_t slice, uint8_t nrOfSlices) override {
+    LedsWriter lights = layerV->writer<CRGB>();
+    //only the lights around the sphere, and only mapped lights if the layout is sparse
+    layerV->forEachLightInShell(origin, diameter, diameter + 1.0f, [&](uint16_t indexV, [[maybe_unused]] uint32_t d2) {
+      lights.set(indexV, CHSV( millis()/50 + random8(64), 200, 255));
+    }, slice, nrOfSlices);
   }
 }; // SphereMove3DEffect
 
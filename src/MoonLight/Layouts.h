@@ -17,6 +17,8 @@ public:
   void setup() override {
     layerV->layerP->lights.header.channelsPerLight = sizeof(CRGB); //default
 
+    if (layerV->layerP->mappingDeferred) return; //mapped when all nodes are created
+
     //redundant?
     for (layerV->layerP->pass = 1; layerV->layerP->pass <= 2; layerV->layerP->pass++)
       map(); //calls also addLayout
@@ -34,9 +36,14 @@ public:
   void map() {
 
     if (on) {
-      layerV->layerP->addLayoutPre();
-      addLayout();
-      layerV->layerP->addLayoutPost();
+      layerV->layerP->mapPass([this]() {
+        layerV->layerP->addLayoutPre();
+        if (layerV->layerP->pass == 1) mapTiming.reset();
+        uint32_t start = ESP.getCycleCount();
+        addLayout();
+        mapTiming.add(ESP.getCycleCount() - start);
+        layerV->layerP->addLayoutPost();
+      });
     } else {
       layerV->resetMapping();
     }
@@ -59,7 +66,6 @@ class DMXLayout: public LayoutNode {
   char type[32] = "CRGBW";
 
   void addControls(JsonArray controls) override {
-    hasLayout = true;
     addControl(controls, &width, "width", "range", 4, 1, 32);
     JsonObject control = addControl(controls, &type, "type", "select", "CRGBW", 1, 32);
     JsonArray values = control["values"].to<JsonArray>();
@@ -94,7 +100,6 @@ class PanelLayout: public LayoutNode {
   bool snake = true;
 
   void addControls(JsonArray controls) override {
-    hasLayout = true;
     addControl(controls, &width, "width", "range", 16, 1, 32);
     addControl(controls, &height, "height", "range", 16, 1, 32);
     addControl(controls, &depth, "depth", "range", 1, 1, 32);
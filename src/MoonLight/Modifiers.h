@@ -22,7 +22,6 @@ class MirrorModifier: public Node {
   Coord3D originalSize;
 
   void addControls(JsonArray controls) override {
-    hasModifier = true;
     addControl(controls, &mirrorX, "mirrorX", "checkbox", true);
     addControl(controls, &mirrorY, "mirrorY", "checkbox", false);
     addControl(controls, &mirrorZ, "mirrorZ", "checkbox", false);
@@ -51,8 +50,6 @@ class MultiplyModifier: public Node {
   Coord3D originalSize;
 
   void modifyLayout() override {
-    hasModifier = true;
-
     layerV->size = (layerV->size + proMulti - Coord3D({1,1,1})) / proMulti; // Round up
     originalSize = layerV->size;
     ESP_LOGD(TAG, "multiply %d %d %d", layerV->size.x, layerV->size.y, layerV->size.z);
@@ -80,7 +77,6 @@ class PinwheelModifier: public Node {
   uint8_t zTwist   = 0;
 
   void addControls(JsonArray controls) override {
-    hasModifier = true;
     addControl(controls, &petals, "petals", "range", 60);
     addControl(controls, &swirlVal, "swirlVal", "range", 30);
     addControl(controls, &reverse, "reverse", "checkbox", false);
@@ -17,6 +17,8 @@
 #undef TAG
 #define TAG "💫"
 
+#define MONITOR_POSITIONS_CHUNK 1024 //layout positions per monitor message (max 6KB), one message per loop50ms
+
 #include "FastLED.h"
 #include "../MoonBase/Module.h"
 
@@ -30,6 +32,29 @@ public:
 
     PsychicHttpServer *_server;
 
+    //render task: frames paced at fps, see _render
+    TaskHandle_t renderTaskHandle = nullptr;
+    uint8_t fps = 50; //target frames per second, 0: as fast as possible (one tick pause per frame)
+    uint32_t frames = 0; //frames and overruns (frames taking longer than 1000/fps ms) since the last loop1s
+    uint32_t frameOverruns = 0;
+    uint32_t outputMicros = 0; //time spend in the outputs since the last loop1s
+
+    //output task: drivers run on the other core while the next frame is rendered
+    TaskHandle_t outputTaskHandle = nullptr;
+    SemaphoreHandle_t outputDone = nullptr; //given by the output task when lightsOut is sent
+    std::vector<std::function<void()>> outputFunctions; //other outputs (e.g. Art-Net) reading lightsOut
+    bool driverOn = true;
+    CRGB *driverLeds = nullptr; //as set in the FastLED controllers, see updateDriverLeds
+    uint16_t driverNrOfLights = 0;
+
+    #if FT_ENABLED(FT_MONITOR)
+        uint32_t monitorFrame = 0; //frameNr of lightsOut at the last send to the monitor
+        unsigned long monitorRefresh = 0; //last time all lights are send, 0: send all lights
+        std::vector<byte> monitorBuffer; //delta and positions messages, reused
+        uint32_t monitorLayoutNr = 0; //layoutNr of the positions send to the monitor
+        size_t monitorPosition = SIZE_MAX; //next position to send to the monitor, SIZE_MAX: all send
+    #endif
+
     ModuleAnimations(PsychicHttpServer *server,
         ESP32SvelteKit *sveltekit,
         FilesService *filesService
@@ -39,9 +64,51 @@ public:
     }
 
     void begin() {
+        layerP.lights.alloc(256 * sizeof(CRGB)); //sized to the layout in pass 2, see PhysicalLayer::addLayoutPost
+
+        //front buffer for the drivers, if no memory, render and output run after each other on lights
+        Lights *lightsOut = new (std::nothrow) Lights();
+        if (lightsOut && !lightsOut->alloc(layerP.lights.maxChannels)) {
+            delete lightsOut;
+            lightsOut = nullptr;
+        }
+        if (lightsOut) {
+            layerP.lightsOut = lightsOut;
+            outputDone = xSemaphoreCreateBinary();
+            xSemaphoreGive(outputDone); //no frame to send yet
+            xTaskCreatePinnedToCore(
+                this->_outputImpl,          // Function that should be called
+                "MoonLight Output",         // Name of the task (for debugging)
+                4096,                       // Stack size (bytes)
+                this,                       // Pass reference to this class instance
+                (tskIDLE_PRIORITY + 2),     // task priority
+                &outputTaskHandle,          // Task handle
+                ESP32SVELTEKIT_RUNNING_CORE // Pin to the other core then the render (Arduino loop) task
+            );
+        } else
+            ESP_LOGW(TAG, "no memory for lightsOut, output not double buffered");
+
+        //the stored nodes are created in Module::begin, map once when all are created: from the mapping cache if nothing changed since the last boot
+        layerP.mappingDeferred = true;
         Module::begin();
+        layerP.mappingDeferred = false;
+        uint32_t key = mappingKey();
+        if (!layerP.loadMapping(key)) {
+            layerP.remap(); //no layout positions yet: runs the layouts
+            layerP.saveMapping(key);
+        }
+
+        xTaskCreatePinnedToCore(
+            this->_renderImpl,          // Function that should be called
+            "MoonLight Render",         // Name of the task (for debugging)
+            8192,                       // Stack size (bytes), as the Arduino loop task
+            this,                       // Pass reference to this class instance
+            (tskIDLE_PRIORITY + 1),     // task priority, as the Arduino loop task
+            &renderTaskHandle,          // Task handle
+            ARDUINO_RUNNING_CORE        // The core of the Arduino loop task, the output task runs on the other core
+        );
 
-        ESP_LOGD(TAG, "L:%d(%d) LH:%d N:%d PL:%d(%d) VL:%d MH:%d", sizeof(Lights), sizeof(LightsHeader), sizeof(Lights) - sizeof(LightsHeader), sizeof(Node), sizeof(PhysicalLayer), sizeof(PhysicalLayer)-sizeof(Lights), sizeof(VirtualLayer), sizeof(MovingHead));
+        ESP_LOGD(TAG, "L:%d(%d) LH:%d N:%d PL:%d(%d) VL:%d MH:%d", sizeof(LightsHeader) + layerP.lights.maxChannels, sizeof(LightsHeader), layerP.lights.maxChannels, sizeof(Node), sizeof(PhysicalLayer), sizeof(PhysicalLayer)-sizeof(Lights), sizeof(VirtualLayer), sizeof(MovingHead));
 
         #if FT_ENABLED(FT_LIVESCRIPT)
             //create a handler which recompiles the animation when the file of the current animation changes in the File Manager
@@ -72,14 +139,8 @@ public:
             _server->on("/rest/monitorLayout", HTTP_GET, [&](PsychicRequest *request) {
                 ESP_LOGD(TAG, "rest monitor triggered");
 
-                //trigger pass 1 mapping of layout
-                for (Node *node : layerP.layerV[0]->nodes) {
-                    if (node->hasLayout && node->on) {
-                        ESP_LOGD(TAG, "Modifier control changed -> setup %s", node->animation);
-                        for (layerP.pass = 1; layerP.pass <=1; layerP.pass++) //only virtual mapping
-                            node->map();
-                    }
-                }
+                //send the layout positions (again), see monitorSendPositions
+                monitorLayoutNr = layerP.layoutNr - 1;
 
                 PsychicJsonResponse response = PsychicJsonResponse(request, false);
                 return response.send();
@@ -87,6 +148,36 @@ public:
         #endif
     }
 
+    //hash of all what the mapping depends on: the layout and modifier nodes with their controls and script files, and the layers
+    uint32_t mappingKey() {
+        uint32_t key = hash32(APP_VERSION, strlen(APP_VERSION));
+        uint8_t nrOfLayers = layerP.layerV.size();
+        key = hash32(&nrOfLayers, sizeof(nrOfLayers), key);
+        uint8_t index = 0;
+        for (JsonObject nodeState: _state.data["nodes"].as<JsonArray>()) {
+            Node *node = index < layerP.nodes.size()?layerP.nodes[index]:nullptr;
+            index++;
+            if (!node || !(node->hasLayout || node->hasModifier)) continue; //effects do not change the mapping
+
+            String settings = nodeState["animation"].as<String>() + nodeState["on"].as<String>() + nodeState["layer"].as<String>();
+            for (JsonObject control: nodeState["controls"].as<JsonArray>()) { //not p: pointers can change
+                settings += control["name"].as<String>() + "=" + control["value"].as<String>() + ";";
+            }
+            key = hash32(settings.c_str(), settings.length(), key);
+
+            if (node->animation[0] == '/') { //live script
+                File file = ESPFS.open(node->animation);
+                if (file) {
+                    uint8_t buffer[128];
+                    size_t length;
+                    while ((length = file.read(buffer, sizeof(buffer))) > 0) key = hash32(buffer, length, key);
+                    file.close();
+                }
+            }
+        }
+        return key;
+    }
+
     //define the data model
     void setupDefinition(JsonArray root) override {
         ESP_LOGD(TAG, "");
@@ -102,6 +193,9 @@ public:
         property = root.add<JsonObject>(); property["name"] = "preset"; property["type"] = "select"; property["default"] = "Preset1"; values = property["values"].to<JsonArray>();
         values.add("Preset1");
         values.add("Preset2");
+        property = root.add<JsonObject>(); property["name"] = "fps"; property["type"] = "number"; property["default"] = 50; property["min"] = 0; property["max"] = 250;
+        property = root.add<JsonObject>(); property["name"] = "frames"; property["type"] = "text"; property["ro"] = true;
+        property = root.add<JsonObject>(); property["name"] = "dualCore"; property["type"] = "checkbox"; property["default"] = false;
         property = root.add<JsonObject>(); property["name"] = "driverOn"; property["type"] = "checkbox"; property["default"] = true;
         property = root.add<JsonObject>(); property["name"] = "pin"; property["type"] = "select"; property["default"] = "16"; values = property["values"].to<JsonArray>();
         values.add("2");
@@ -111,28 +205,21 @@ public:
             property = root.add<JsonObject>(); property["name"] = "monitorOn"; property["type"] = "checkbox"; property["default"] = true;
         #endif
 
+        property = root.add<JsonObject>(); property["name"] = "layers"; property["type"] = "array"; details = property["n"].to<JsonArray>();
+        {
+            property = details.add<JsonObject>(); property["name"] = "blend"; property["type"] = "select"; property["default"] = "Add"; values = property["values"].to<JsonArray>();
+            values.add("Add");
+            values.add("Alpha");
+            values.add("Max");
+            values.add("Multiply");
+            property = details.add<JsonObject>(); property["name"] = "opacity"; property["type"] = "range"; property["default"] = 255;
+        }
+
         property = root.add<JsonObject>(); property["name"] = "nodes"; property["type"] = "array"; details = property["n"].to<JsonArray>();
         {
             property = details.add<JsonObject>(); property["name"] = "animation"; property["type"] = "selectFile"; property["default"] = "Random🔥"; values = property["values"].to<JsonArray>();
-            values.add("Solid🔥");
-            //alphabetically from here
-            values.add("BouncingBalls🔥");
-            values.add("Lines🔥");
-            values.add("Lissajous🔥");
-            values.add("MovingHead🔥");
-            values.add("Rainbow🔥");
-            values.add("Random🔥");
-            values.add("RipplesEffect🔥");
-            values.add("RGBWPar🔥");
-            values.add("Sinelon🔥");
-            values.add("Sinus🔥");
-            values.add("SphereMoveEffect🔥");
-            values.add("DMX🚥");
-            values.add("Panel🚥");
-            values.add("Rings🚥");
-            values.add("Mirror💎");
-            values.add("Multiply💎");
-            values.add("Pinwheel💎");
+            for (size_t i = 0; i < nrOfNodeTypes; i++)
+                values.add(nodeTypes[i].animation);
             //find all the .sc files on FS
             File rootFolder = ESPFS.open("/");
             walkThroughFiles(rootFolder, [&](File folder, File file) {
@@ -143,6 +230,8 @@ public:
             });
             rootFolder.close();
             property = details.add<JsonObject>(); property["name"] = "on"; property["type"] = "checkbox"; property["default"] = true;
+            property = details.add<JsonObject>(); property["name"] = "layer"; property["type"] = "number"; property["default"] = 0; property["min"] = 0; property["max"] = 3;
+            property = details.add<JsonObject>(); property["name"] = "stats"; property["type"] = "text"; property["ro"] = true;
             property = details.add<JsonObject>(); property["name"] = "controls"; property["type"] = "controls"; details = property["n"].to<JsonArray>();
             {
                 property = details.add<JsonObject>(); property["name"] = "name"; property["type"] = "text"; property["default"] = "speed";
@@ -183,12 +272,12 @@ public:
             //addLeds twice is temp hack to make rgb sliders work
             switch (_state.data["pin"].as<int>()) {
                 case 2:
-                    FastLED.addLeds<WS2812B, 16, GRB>(layerP.lights.leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
-                    FastLED.addLeds<WS2812B, 2, GRB>(layerP.lights.leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
+                    FastLED.addLeds<WS2812B, 16, GRB>(layerP.lightsOut->leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
+                    FastLED.addLeds<WS2812B, 2, GRB>(layerP.lightsOut->leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
                     break;
                 case 16:
-                    FastLED.addLeds<WS2812B, 2, GRB>(layerP.lights.leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
-                    FastLED.addLeds<WS2812B, 16, GRB>(layerP.lights.leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
+                    FastLED.addLeds<WS2812B, 2, GRB>(layerP.lightsOut->leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
+                    FastLED.addLeds<WS2812B, 16, GRB>(layerP.lightsOut->leds, 0, layerP.lights.header.nrOfLights).setCorrection(CRGB(_state.data["red"],_state.data["green"],_state.data["blue"]));
                     break;
                 default:
                     ESP_LOGD(TAG, "unknown pin %d", _state.data["pin"].as<int>());
@@ -196,19 +285,39 @@ public:
             FastLED.setMaxPowerInMilliWatts(10000); // 5v, 2000mA, to protect usb while developing
             // layerP.lights.header.brightness = _state.data["lightsOn"]?_state.data["brightness"]:0;
             // FastLED.setBrightness(layerP.lights.header.brightness);
+            driverLeds = nullptr; //resync the new controllers with lightsOut in frameDone
             ESP_LOGD(TAG, "FastLED.addLeds n:%d", layerP.lights.header.nrOfLights);
+        } else if (equal(updatedItem.name, "fps")) {
+            fps = updatedItem.value;
+        } else if (equal(updatedItem.name, "dualCore")) {
+            layerP.nrOfSlices = updatedItem.value.as<bool>()?2:1; //effects which support it render on both cores
+        } else if (equal(updatedItem.name, "driverOn")) {
+            driverOn = updatedItem.value;
         } else if (equal(updatedItem.name, "lightsOn") || equal(updatedItem.name, "brightness")) {
             ESP_LOGD(TAG, "handle %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
             layerP.lights.header.brightness = _state.data["lightsOn"]?_state.data["brightness"]:0;
             FastLED.setBrightness(layerP.lights.header.brightness);
 
+        // handle layers
+        } else if (equal(updatedItem.parent[0], "layers")) { // onLayers
+            ESP_LOGD(TAG, "handle %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
+            VirtualLayer *layer = layerP.getLayer(updatedItem.index[0]);
+            if (equal(updatedItem.name, "blend")) {
+                if (updatedItem.value == "Alpha") layer->blendMode = bm_alpha;
+                else if (updatedItem.value == "Max") layer->blendMode = bm_max;
+                else if (updatedItem.value == "Multiply") layer->blendMode = bm_multiply;
+                else layer->blendMode = bm_add;
+            } else if (equal(updatedItem.name, "opacity")) {
+                layer->opacity = updatedItem.value;
+            }
+
         // handle nodes
         } else if (equal(updatedItem.parent[0], "nodes")) { // onNodes
             JsonVariant nodeState = _state.data["nodes"][updatedItem.index[0]];
 
             if (equal(updatedItem.name, "animation")) { //onAnimation
 
-                Node *oldNode = layerP.layerV[0]->nodes.size() > updatedItem.index[0]?layerP.layerV[0]->nodes[updatedItem.index[0]]:nullptr; //find the node in the nodes list
+                Node *oldNode = layerP.nodes.size() > updatedItem.index[0]?layerP.nodes[updatedItem.index[0]]:nullptr; //find the node in the nodes list
                 bool newNode = false;
 
                 if (updatedItem.oldValue != "null") {
@@ -219,7 +328,7 @@ public:
                 if (!nodeState["animation"].isNull()) { // if animation changed // == updatedItem.value
                     ESP_LOGD(TAG, "add %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
     
-                    Node *nodeClass = layerP.addNode(nodeState["animation"], updatedItem.index[0]);
+                    Node *nodeClass = layerP.addNode(nodeState["animation"], updatedItem.index[0], nodeState["layer"]);
                     nodeClass->on = nodeState["on"];
                     newNode = true;
 
@@ -247,13 +356,8 @@ public:
 
                     //if node is a modifier, run the layout definition
                     if (nodeClass->hasModifier) {
-                        for (Node *node : layerP.layerV[0]->nodes) {
-                            if (node->hasLayout && node->on) {
-                                ESP_LOGD(TAG, "Modifier control changed -> setup %s", node->animation);
-                                for (layerP.pass = 1; layerP.pass <=2; layerP.pass++) //only virtual mapping
-                                    node->map();
-                            }
-                        }
+                        ESP_LOGD(TAG, "Modifier changed -> remap");
+                        layerP.remap();
                     }
                 }
 
@@ -261,8 +365,8 @@ public:
                 if (updatedItem.oldValue != "null" && oldNode) {
                     ESP_LOGD(TAG, "remove %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
                     if (!newNode) {
-                        layerP.layerV[0]->nodes.pop_back();
-                        ESP_LOGD(TAG, "No newnode - remove! %d s:%d", updatedItem.index[0], layerP.layerV[0]->nodes.size());
+                        layerP.nodes.pop_back();
+                        ESP_LOGD(TAG, "No newnode - remove! %d s:%d", updatedItem.index[0], layerP.nodes.size());
                     }
                     layerP.removeNode(oldNode);
                 }
@@ -283,19 +387,14 @@ public:
             }
 
             if (equal(updatedItem.name, "on")) {
-                if (layerP.layerV[0]->nodes.size() > updatedItem.index[0]) { //could be remoced by onAnimation
-                    Node *nodeClass = layerP.layerV[0]->nodes[updatedItem.index[0]];
+                if (layerP.nodes.size() > updatedItem.index[0]) { //could be remoced by onAnimation
+                    Node *nodeClass = layerP.nodes[updatedItem.index[0]];
                     if (nodeClass) {
                         ESP_LOGD(TAG, "on %s", updatedItem.name);
                         nodeClass->on = updatedItem.value.as<bool>(); //set nodeclass on/off
                         if (nodeClass->hasModifier) { //nodeClass->on && //if class has modifier, run the layout (if on) - which uses all the modifiers ...
-                            for (Node *node : layerP.layerV[0]->nodes) {
-                                if (node->hasLayout && node->on) {
-                                    ESP_LOGD(TAG, "Modifier control changed -> setup %s", node->animation);
-                                    for (layerP.pass = 1; layerP.pass <=2; layerP.pass++) //only virtual mapping
-                                        node->map();
-                                }
-                            }
+                            ESP_LOGD(TAG, "Modifier on changed -> remap");
+                            layerP.remap();
                         }
                         if (nodeClass->hasLayout) {
                             //if layout has been set to off, remove the mapping
@@ -305,10 +404,23 @@ public:
                 }
             }
 
+            if (equal(updatedItem.name, "layer")) {
+                if (layerP.nodes.size() > updatedItem.index[0]) { //could be removed by onAnimation
+                    Node *nodeClass = layerP.nodes[updatedItem.index[0]];
+                    if (nodeClass) {
+                        layerP.moveNode(nodeClass, updatedItem.value.as<uint8_t>());
+                        if (nodeClass->hasModifier) { //the modifier now works on another layer, run the layout
+                            ESP_LOGD(TAG, "Modifier layer changed -> remap");
+                            layerP.remap();
+                        }
+                    }
+                }
+            }
+
             if (equal(updatedItem.parent[1], "controls") && equal(updatedItem.name, "value")) {    //process controls values 
                 ESP_LOGD(TAG, "handle %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
-                if (layerP.layerV[0]->nodes.size() > updatedItem.index[0]) { //could be removed by onAnimation
-                    Node *nodeClass = layerP.layerV[0]->nodes[updatedItem.index[0]];
+                if (layerP.nodes.size() > updatedItem.index[0]) { //could be removed by onAnimation
+                    Node *nodeClass = layerP.nodes[updatedItem.index[0]];
                     if (nodeClass) {
                         nodeClass->updateControl(nodeState["controls"][updatedItem.index[1]]);
                         // if Modfier control changed, run the layout
@@ -318,13 +430,8 @@ public:
 
                         // ESP_LOGD(TAG, "nodeClass type %s", nodeClass->scriptType);
                         if (nodeClass->on && nodeClass->hasModifier) {
-                            for (Node *node : layerP.layerV[0]->nodes) {
-                                if (node->hasLayout && node->on) {
-                                    ESP_LOGD(TAG, "Modifier control changed -> setup layout %s", node->animation);
-                                    for (layerP.pass = 1; layerP.pass <= 2; layerP.pass++) //only virtual mapping
-                                        node->map();
-                                }
-                            }
+                            ESP_LOGD(TAG, "Modifier control changed -> remap");
+                            layerP.remap();
                         }
                     }
                     else ESP_LOGW(TAG, "nodeClass not found %s", nodeState["animation"].as<String>().c_str());
@@ -357,6 +464,41 @@ public:
         // ESP_LOGD(TAG, "no handle for %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
     }
 
+    static void _renderImpl(void *_this) { static_cast<ModuleAnimations *>(_this)->_render(); }
+
+    //render a frame each 1000/fps ms, frames which take longer are counted as overrun and start a new period (no catch up frames)
+    void _render() {
+        TickType_t lastWake = xTaskGetTickCount();
+        for (;;) {
+            //network input: no effects, a frame is output as soon as the receiver has it complete
+            if (layerP.receiving) {
+                if (xSemaphoreTake(layerP.frameReceived, pdMS_TO_TICKS(100)) == pdTRUE) {
+                    frameDone();
+                    frames++;
+                }
+                lastWake = xTaskGetTickCount();
+                continue;
+            }
+
+            unsigned long start = micros();
+            loop();
+            unsigned long frameTime = micros() - start;
+            frames++;
+
+            if (fps) {
+                TickType_t period = pdMS_TO_TICKS(1000 / fps);
+                if (frameTime > 1000000 / fps) frameOverruns++;
+                if (xTaskGetTickCount() - lastWake >= period)
+                    lastWake = xTaskGetTickCount(); //too late for this period
+                else
+                    vTaskDelayUntil(&lastWake, period);
+            } else {
+                lastWake = xTaskGetTickCount();
+                vTaskDelay(1); //block one tick, a yield only lets tasks of the same priority run: the idle task would starve and trigger the task watchdog
+            }
+        }
+    }
+
     //run effects
     void loop()
     {
@@ -369,32 +511,244 @@ public:
         //     layerP.lights.leds[i] = CRGB(0, 0, 128);
         // }
 
+        frameDone();
+    }
+
+    //hand over the rendered frame to the output task
+    void frameDone() {
+        if (outputTaskHandle) {
+            //wait until the previous frame is sent, then lightsOut can be overwritten
+            if (layerP.lights.header.type == ct_Leds && xSemaphoreTake(outputDone, pdMS_TO_TICKS(100)) == pdTRUE) {
+                //output task is idle now, so lightsOut can be resized and written
+                //copy, not swap: effects continue on the previous frame (e.g. fadeToBlackBy)
+                layerP.copyToLightsOut();
+                updateDriverLeds();
+                xTaskNotifyGive(outputTaskHandle);
+            }
+        } else {
+            if (layerP.lights.header.type == ct_Leds) layerP.copyToLightsOut(); //lightsOut is lights: only marks all blocks changed
+            updateDriverLeds();
+            output();
+        }
+    }
+
+    //send lightsOut to the drivers and the other outputs
+    void output() {
+        unsigned long start = micros();
         driverShow();
+        for (auto &function : outputFunctions)
+            function();
+        outputMicros += micros() - start;
+    }
+
+    //the lights buffers are (re)allocated when the layout changes, let the drivers follow
+    void updateDriverLeds() {
+        uint16_t nrOfLights = MIN(layerP.lightsOut->header.nrOfLights, layerP.lightsOut->maxChannels / sizeof(CRGB));
+        if (layerP.lightsOut->leds != driverLeds || nrOfLights != driverNrOfLights) {
+            for (int i = 0; i < FastLED.count(); i++)
+                FastLED[i].setLeds(layerP.lightsOut->leds, nrOfLights);
+            driverLeds = layerP.lightsOut->leds;
+            driverNrOfLights = nrOfLights;
+        }
+    }
+
+    static void _outputImpl(void *_this) { static_cast<ModuleAnimations *>(_this)->_output(); }
+
+    void _output() {
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); //wait for frameDone
+
+            output();
+
+            xSemaphoreGive(outputDone);
+        }
+    }
+
+    void addOutputFunction(std::function<void()> function) {
+        outputFunctions.push_back(function);
     }
 
     void loop50ms() {
         #if FT_ENABLED(FT_MONITOR)
 
+            if (!_socket->getConnectedClients() || !_state.data["monitorOn"]) return;
+
+            //a new layout: first all positions, one chunk each call, then the lights
+            if (monitorSendPositions()) {
+                monitorRefresh = 0; //new scene, send all lights
+                return;
+            }
+
             static int monitorMillis = 0;
             if (millis() - monitorMillis >= layerP.lights.header.nrOfLights / 12) { //max 12000 leds per second -> 1 second for 12000 leds
                 monitorMillis = millis();
                 
-                if (layerP.lights.header.type == ct_Position) { //send to UI
-                    if (_socket->getConnectedClients() && _state.data["monitorOn"])
-                        _socket->emitEvent("monitor", (char *)&layerP.lights, sizeof(LightsHeader) + MIN(layerP.lights.header.nrOfLights * sizeof(Coord3D), MAX_CHANNELS));
-                    layerP.lights.header.type = ct_Leds; //back to normal
-                } else if (layerP.lights.header.type == ct_Leds) {//send to UI
-                    if (_socket->getConnectedClients() && _state.data["monitorOn"])
-                        _socket->emitEvent("monitor", (char *)&layerP.lights, sizeof(LightsHeader) + MIN(layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight, MAX_CHANNELS));
+                if (layerP.lights.header.type == ct_Leds) {//send to UI
+                    monitorSend();
                 }
             }
         #endif
     }
 
+    #if FT_ENABLED(FT_MONITOR)
+    //the next MONITOR_POSITIONS_CHUNK layout positions (header.offset: index of the first), 1 byte per coordinate if the layout fits in 256x256x256, 2 bytes otherwise
+    //returns false if there is nothing to send
+    bool monitorSendPositions() {
+        if (monitorLayoutNr != layerP.layoutNr) { //new layout: start again
+            monitorLayoutNr = layerP.layoutNr;
+            monitorPosition = 0;
+        }
+        if (monitorPosition == SIZE_MAX) return false;
+
+        xSemaphoreTake(layerP.mappingMutex, portMAX_DELAY); //no layout (pass 1) changing layoutPositions
+        const std::vector<Coord3D16> &positions = layerP.layoutPositions;
+        LightsHeader header = layerP.lights.header;
+        header.type = ct_Position;
+        header.nrOfLights = positions.size();
+        header.offset = monitorPosition;
+        bool wide = header.size.x > 256 || header.size.y > 256 || header.size.z > 256;
+        size_t nrOfPositions = MIN(positions.size() - MIN(monitorPosition, positions.size()), MONITOR_POSITIONS_CHUNK);
+
+        monitorBuffer.resize(sizeof(LightsHeader) + nrOfPositions * (wide?sizeof(Coord3D16):3));
+        memcpy(monitorBuffer.data(), &header, sizeof(LightsHeader));
+        byte *data = monitorBuffer.data() + sizeof(LightsHeader);
+        if (wide)
+            memcpy(data, &positions[monitorPosition], nrOfPositions * sizeof(Coord3D16)); //little endian
+        else {
+            for (size_t i = monitorPosition; i < monitorPosition + nrOfPositions; i++) {
+                *data++ = positions[i].x;
+                *data++ = positions[i].y;
+                *data++ = positions[i].z;
+            }
+        }
+        monitorPosition += nrOfPositions;
+        if (monitorPosition >= positions.size()) monitorPosition = SIZE_MAX; //all send
+        xSemaphoreGive(layerP.mappingMutex);
+
+        _socket->emitEvent("monitor", (char *)monitorBuffer.data(), monitorBuffer.size());
+        return true;
+    }
+
+    //all lights once a second (e.g. for new clients), in between only the blocks changed since the last send (header.delta)
+    void monitorSend() {
+        //copied into monitorBuffer with lightsOutMutex taken: frameDone (render task) can resize and write lightsOut meanwhile
+        xSemaphoreTake(layerP.lightsOutMutex, portMAX_DELAY);
+        Lights *lightsOut = layerP.lightsOut;
+        size_t nrOfChannels = MIN(lightsOut->header.nrOfLights * lightsOut->header.channelsPerLight, lightsOut->maxChannels);
+
+        if (millis() - monitorRefresh < 1000 && monitorRefresh) {
+            if (layerP.frameNr == monitorFrame) { //no new frame
+                xSemaphoreGive(layerP.lightsOutMutex);
+                return;
+            }
+
+            //delta: ranges of changed blocks
+            monitorBuffer.resize(sizeof(LightsHeader));
+            size_t nrOfBlocks = layerP.blockChanged.size();
+            for (size_t block = 0; block < nrOfBlocks; block++) {
+                if (layerP.blockChanged[block] <= monitorFrame) continue;
+                size_t firstBlock = block;
+                while (block + 1 < nrOfBlocks && layerP.blockChanged[block + 1] > monitorFrame && block + 1 - firstBlock < UINT16_MAX) block++;
+                uint16_t range[2] = {(uint16_t)firstBlock, (uint16_t)(block + 1 - firstBlock)};
+                size_t start = firstBlock * DIRTY_BLOCK_SIZE;
+                size_t length = MIN((block + 1) * DIRTY_BLOCK_SIZE, nrOfChannels) - start;
+                monitorBuffer.insert(monitorBuffer.end(), (byte *)range, (byte *)range + sizeof(range));
+                monitorBuffer.insert(monitorBuffer.end(), &lightsOut->channels[start], &lightsOut->channels[start] + length);
+                if (monitorBuffer.size() >= sizeof(LightsHeader) + nrOfChannels) break; //no gain, send all lights
+            }
+            monitorFrame = layerP.frameNr;
+
+            if (monitorBuffer.size() == sizeof(LightsHeader)) { //nothing changed
+                xSemaphoreGive(layerP.lightsOutMutex);
+                return;
+            }
+            if (monitorBuffer.size() < sizeof(LightsHeader) + nrOfChannels) {
+                memcpy(monitorBuffer.data(), &lightsOut->header, sizeof(LightsHeader));
+                ((LightsHeader *)monitorBuffer.data())->delta = true;
+                xSemaphoreGive(layerP.lightsOutMutex);
+                _socket->emitEvent("monitor", (char *)monitorBuffer.data(), monitorBuffer.size());
+                return;
+            }
+        }
+
+        byte *headerAndChannels = lightsOut->headerAndChannels();
+        monitorBuffer.assign(headerAndChannels, headerAndChannels + sizeof(LightsHeader) + nrOfChannels);
+        monitorFrame = layerP.frameNr;
+        xSemaphoreGive(layerP.lightsOutMutex);
+
+        _socket->emitEvent("monitor", (char *)monitorBuffer.data(), monitorBuffer.size());
+        monitorRefresh = millis();
+    }
+    #endif
+
     //update scripts / read only values in the UI
     void loop1s() {
 
-        if (!_socket->getConnectedClients()) return; 
+        //frame statistics of the last second
+        uint32_t nrOfFrames = frames;
+        Char<96> stats;
+        stats.format("%d fps, %d overruns, effects %.1fms compose %.1fms output %.1fms", nrOfFrames, frameOverruns,
+                        nrOfFrames?layerP.effectsMicros / 1000.0f / nrOfFrames:0, nrOfFrames?layerP.composeMicros / 1000.0f / nrOfFrames:0, nrOfFrames?outputMicros / 1000.0f / nrOfFrames:0);
+        frames = 0;
+        frameOverruns = 0;
+        layerP.effectsMicros = 0;
+        layerP.composeMicros = 0;
+        outputMicros = 0;
+
+        //copy the telemetry of the nodes with mappingMutex taken: the render task writes the timings, and removeNode waits with deleting a node
+        struct NodeStats {
+            NodeTiming loopTiming;
+            NodeTiming mapTiming;
+            NodeTiming modifyTiming;
+            int32_t heapSize;
+            size_t arenaSize;
+        };
+        bool connected = _socket->getConnectedClients();
+        std::vector<NodeStats> nodeStats;
+        xSemaphoreTake(layerP.mappingMutex, portMAX_DELAY);
+        if (connected) nodeStats.reserve(layerP.nodes.size());
+        for (Node *node: layerP.nodes) {
+            if (connected) nodeStats.push_back({node->loopTiming, node->mapTiming, node->modifyTiming, node->heapSize, node->arena.size});
+            node->loopTiming.reset();
+        }
+        xSemaphoreGive(layerP.mappingMutex);
+
+        if (!connected) return;
+
+        {
+            JsonDocument newData; //to only send updatedData
+            newData["frames"] = String(stats.c_str()); //read only: only send, not in the state as that is written to file
+
+            //per node: loop of the last second, map and modifyLight of the last mapping (min/avg/max) and heap
+            JsonArray nodes = newData["nodes"].to<JsonArray>(); //one row for each row in the state, otherwise the UI removes rows
+            size_t rows = _state.data["nodes"].as<JsonArray>().size();
+            float cyclesPerMicro = ESP.getCpuFreqMHz();
+            for (size_t index = 0; index < rows; index++) {
+                String text;
+                if (index < nodeStats.size()) {
+                    const NodeStats &node = nodeStats[index];
+                    char part[64];
+                    if (node.loopTiming.count) {
+                        snprintf(part, sizeof(part), "loop %.0f/%.0f/%.0fus ", node.loopTiming.min / cyclesPerMicro, node.loopTiming.total / cyclesPerMicro / node.loopTiming.count, node.loopTiming.max / cyclesPerMicro);
+                        text += part;
+                    }
+                    if (node.mapTiming.count) {
+                        snprintf(part, sizeof(part), "map %.0fus ", node.mapTiming.total / cyclesPerMicro);
+                        text += part;
+                    }
+                    if (node.modifyTiming.count) {
+                        snprintf(part, sizeof(part), "modify %.2f/%.2f/%.2fus ", node.modifyTiming.min / cyclesPerMicro, node.modifyTiming.total / cyclesPerMicro / node.modifyTiming.count, node.modifyTiming.max / cyclesPerMicro);
+                        text += part;
+                    }
+                    snprintf(part, sizeof(part), node.arenaSize?"heap %dB arena %dB":"heap %dB", node.heapSize, (int)node.arenaSize);
+                    text += part;
+                }
+                nodes.add<JsonObject>()["stats"] = text;
+            }
+
+            JsonObject newDataObject = newData.as<JsonObject>();
+            _socket->emitEvent("animations", newDataObject);
+        }
 
         #if FT_ENABLED(FT_LIVESCRIPT)
             JsonDocument newData; //to only send updatedData
@@ -433,13 +787,13 @@ public:
 
     void driverShow()
     {
-        if (layerP.lights.header.type == ct_Leds && _state.data["driverOn"] && FastLED.count()) {
+        if (layerP.lightsOut->header.type == ct_Leds && layerP.lightsOut->leds && driverOn && FastLED.count()) {
             FastLED.show();
         }
     }
 
     Node *findNode(const char *animation) {
-        for (Node *node : layerP.layerV[0]->nodes) {
+        for (Node *node : layerP.nodes) {
             // Check if the node is of type LiveScriptNode
 
                 if (equal(node->animation, animation)) {
@@ -18,9 +18,41 @@
 #include <AsyncUDP.h>
 
 #define ARTNET_DEFAULT_PORT 6454
+#define ARTNET_REFRESH_MS 1000 //unchanged universes are resend at least this often (keep-alive)
+#define ARTNET_CHANNELS_PER_PACKET 510 // 512/4=128 RGBW LEDs, 510/3=170 RGB LEDs
 
 const size_t ART_NET_HEADER_SIZE = 12;
 const byte   ART_NET_HEADER[] PROGMEM = {0x41,0x72,0x74,0x2d,0x4e,0x65,0x74,0x00,0x00,0x50,0x00,0x0e};
+//OpSync: receivers output the universes received since the previous ArtSync at the same time, followed by Aux1, Aux2
+const byte   ART_SYNC_PACKET[] PROGMEM = {0x41,0x72,0x74,0x2d,0x4e,0x65,0x74,0x00,0x00,0x52,0x00,0x0e,0x00,0x00};
+
+//E1.31 (sACN): root layer (0..37), framing layer (38..114) and DMP layer (115..125, ending with the start code), followed by the channels
+#define E131_DEFAULT_PORT 5568
+const size_t E131_HEADER_SIZE = 126;
+//preamble size, postamble size, ACN packet identifier, root flags and length (set per packet), VECTOR_ROOT_E131_DATA
+const byte   E131_ROOT_HEADER[] PROGMEM = {0x00,0x10,0x00,0x00,0x41,0x53,0x43,0x2d,0x45,0x31,0x2e,0x31,0x37,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x00,0x04};
+//DMP: flags and length (set per packet), VECTOR_DMP_SET_PROPERTY, address and data type, first property address, address increment
+const byte   E131_DMP_HEADER[] PROGMEM = {0x70,0x00,0x02,0xa1,0x00,0x00,0x00,0x01};
+
+//DDP: 10 bytes header (flags, sequence, data type, destination, 32 bits offset, 16 bits length), then the channels at offset
+#define DDP_DEFAULT_PORT 4048
+const size_t DDP_HEADER_SIZE = 10;
+#define DDP_CHANNELS_PER_PACKET 1440 //480 RGB or 360 RGBW lights, fits in one Wi-Fi frame
+
+enum OutputProtocol {
+    pr_ArtNet,
+    pr_E131,
+    pr_DDP
+};
+
+//the lightsOut channels send in one universe (packet), DDP: in one packet
+struct ArtnetUniverse {
+    uint32_t offset; //first channel in lightsOut
+    uint16_t size; //nr of channels, max ARTNET_CHANNELS_PER_PACKET
+    uint16_t universe; //15 bits: net, subnet and universe (E1.31: universe + 1 as E1.31 universes start at 1)
+    uint8_t lightChannel; //channel of the light at offset (universes can start in the middle of a light)
+    uint8_t priority; //E1.31 priority of the output
+};
 
 class ModuleArtnet : public Module
 {
@@ -29,7 +61,29 @@ public:
     IPAddress controllerIP; //tbd: controllerIP also configurable from fixtures and artnet instead of pin output
     std::vector<uint16_t> hardware_outputs = {1024,1024,1024,1024,1024,1024,1024,1024};
     std::vector<uint16_t> hardware_outputs_universe_start = { 0,7,14,21,28,35,42,49 }; //7*170 = 1190 leds => last universe not completely used
+    std::vector<uint8_t> hardware_outputs_priority = {100,100,100,100,100,100,100,100}; //E1.31
+    OutputProtocol protocol = pr_ArtNet;
+    bool multicast = false; //E1.31: send to the multicast address of each universe instead of to controllerIP
     size_t sequenceNumber = 0;
+    bool on = true; //not from _state.data as sendFrame runs in the output task
+    uint8_t fps = 50; //max frames per second send, 0: each frame
+    bool sync = false; //send ArtSync after the universes of a frame (Art-Net)
+    unsigned long lastSend = 0;
+    uint32_t lastFrame = 0; //frameNr of lightsOut at the last send, only universes changed after it are send
+    unsigned long lastRefresh = 0; //last time all universes are send
+    bool refresh = true; //send all universes next time (e.g. outputs changed)
+
+    //prepared once, not per frame
+    AsyncUDP artnetudp; // AsyncUDP so we can just blast packets.
+    byte packet[DDP_HEADER_SIZE + DDP_CHANNELS_PER_PACKET]; //the biggest packet, header set in buildPacketTemplate, only sequence, universe / offset, priority and lengths change per packet
+    size_t headerSize = 0; //channels start at packet + headerSize
+    int8_t packetProtocol = -1; //protocol of packet and universes, -1: not build yet
+    std::vector<ArtnetUniverse> universes; //build by buildUniverses if the outputs or the lights change
+    bool outputsChanged = true;
+    size_t universesChannels = 0; //nr of channels of lightsOut when universes was build
+    uint8_t universesChannelsPerLight = 0;
+    uint8_t scale[256]; //brightness scaled value of each channel value
+    uint16_t scaleBrightness = UINT16_MAX; //brightness of scale, UINT16_MAX: not build yet
 
     ModuleArtnet(PsychicHttpServer *server,
             ESP32SvelteKit *sveltekit,
@@ -45,12 +99,20 @@ public:
         JsonArray values; // if a property is a select, this is the values of the select
 
         property = root.add<JsonObject>(); property["name"] = "on"; property["type"] = "checkbox"; property["default"] = true;
+        property = root.add<JsonObject>(); property["name"] = "protocol"; property["type"] = "select"; property["default"] = "Art-Net"; values = property["values"].to<JsonArray>();
+        values.add("Art-Net");
+        values.add("E1.31");
+        values.add("DDP");
         property = root.add<JsonObject>(); property["name"] = "controllerIP"; property["type"] = "number"; property["min"] = 2; property["max"] = 255; property["default"] = 11;
+        property = root.add<JsonObject>(); property["name"] = "fps"; property["type"] = "number"; property["default"] = 50; property["min"] = 0; property["max"] = 250;
+        property = root.add<JsonObject>(); property["name"] = "sync"; property["type"] = "checkbox"; property["default"] = false;
+        property = root.add<JsonObject>(); property["name"] = "multicast"; property["type"] = "checkbox"; property["default"] = false;
 
         property = root.add<JsonObject>(); property["name"] = "outputs"; property["type"] = "array"; details = property["n"].to<JsonArray>();
         {
             property = details.add<JsonObject>(); property["name"] = "start"; property["type"] = "number"; property["default"] = 0; property["min"] = 3; property["max"] = 32; 
             property = details.add<JsonObject>(); property["name"] = "size"; property["type"] = "number"; property["default"] = 1024;
+            property = details.add<JsonObject>(); property["name"] = "priority"; property["type"] = "number"; property["default"] = 100; property["min"] = 0; property["max"] = 200;
         }
 
 
@@ -63,10 +125,27 @@ public:
 
     void onUpdate(UpdatedItem &updatedItem) override
     {
-        if (equal(updatedItem.name, "controllerIP")) {
+        if (equal(updatedItem.name, "on")) {
+            on = updatedItem.value;
+        }
+        else if (equal(updatedItem.name, "controllerIP")) {
             controllerIP[3] = updatedItem.value;
             ESP_LOGD(TAG, "controllerIP = %s", controllerIP.toString().c_str());
         }
+        else if (equal(updatedItem.name, "protocol")) {
+            if (updatedItem.value == "E1.31") protocol = pr_E131;
+            else if (updatedItem.value == "DDP") protocol = pr_DDP;
+            else protocol = pr_ArtNet; //packet and universes are rebuild in sendFrame
+        }
+        else if (equal(updatedItem.name, "multicast")) {
+            multicast = updatedItem.value;
+        }
+        else if (equal(updatedItem.name, "fps")) {
+            fps = updatedItem.value;
+        }
+        else if (equal(updatedItem.name, "sync")) {
+            sync = updatedItem.value;
+        }
         else if (equal(updatedItem.parent[0], "outputs")) { // onNodes
             JsonVariant outputs = _state.data["outputs"][updatedItem.index[0]];
 
@@ -78,16 +157,24 @@ public:
                 ESP_LOGD(TAG, "Size[%d] = %d", updatedItem.index[0], updatedItem.value.as<int>());
                 hardware_outputs[updatedItem.index[0]] = updatedItem.value;
             }
+            if (equal(updatedItem.name, "priority")) {
+                hardware_outputs_priority[updatedItem.index[0]] = updatedItem.value;
+            }
+            outputsChanged = true;
         }
         else
             ESP_LOGD(TAG, "no handle for %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
     }
 
-void loop20ms() {
+//called by the output task when a frame is rendered, so universes of different frames are not mixed
+void sendFrame() {
 
     // if(!mdls->isConnected) return;
 
-    if (!_state.data["on"]) return;
+    if (!on) return;
+
+    //max refresh rate: skipped frames are in the next send as changedSince counts from the last send
+    if (fps && millis() - lastSend < 1000 / fps) return;
 
     controllerIP[0] = WiFi.localIP()[0];
     controllerIP[1] = WiFi.localIP()[1];
@@ -95,79 +182,174 @@ void loop20ms() {
 
     if(!controllerIP) return;
 
+    if (layerP.lightsOut->header.type != ct_Leds) return; //lightsOut contains positions etc.
+
     // if(!eff->newFrame) return;
 
-    uint8_t bri = layerP.lights.header.brightness;
+    const LightsHeader &header = layerP.lightsOut->header;
+
+    //read once: onUpdate (HTTP task) can change it while a frame is send, the header size of the template and the universe sizes must be of the same protocol
+    OutputProtocol protocol = this->protocol;
 
-    // calculate the number of UDP packets we need to send
+    if (protocol != packetProtocol) {
+        packetProtocol = protocol;
+        buildPacketTemplate(protocol);
+        refresh = true;
+    }
 
-    byte packet_buffer[ART_NET_HEADER_SIZE + 6 + 512];
-    memcpy(packet_buffer, ART_NET_HEADER, 12); // copy in the Art-Net header.
+    if (outputsChanged || header.nrOfLights * header.channelsPerLight != universesChannels || header.channelsPerLight != universesChannelsPerLight) {
+        outputsChanged = false;
+        buildUniverses(protocol);
+        refresh = true;
+    }
 
-    AsyncUDP artnetudp;// AsyncUDP so we can just blast packets.
+    if (header.brightness != scaleBrightness) {
+        scaleBrightness = header.brightness;
+        for (int value = 0; value < 256; value++) scale[value] = (value * scaleBrightness) >> 8;
+        refresh = true; //all channels changed
+    }
+
+    //only universes with changed channels, all universes once per ARTNET_REFRESH_MS
+    bool sendAll = refresh || millis() - lastRefresh >= ARTNET_REFRESH_MS;
+    if (sendAll) {
+        lastRefresh = millis();
+        refresh = false;
+    }
+    uint32_t sinceFrame = lastFrame;
+    lastFrame = layerP.frameNr;
+    lastSend = millis();
 
-    uint_fast16_t bufferOffset = 0;
-    uint_fast16_t hardware_output_universe = 0;
-    
     sequenceNumber++;
 
     if (sequenceNumber == 0) sequenceNumber = 1; // just in case, as 0 is considered "Sequence not in use"
     if (sequenceNumber > 255) sequenceNumber = 1;
-    
-    for (uint_fast16_t hardware_output = 0; hardware_output < hardware_outputs.size(); hardware_output++) { //loop over all outputs
-        
-        if (bufferOffset > layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight) {
-            // This stop is reached if we don't have enough pixels for the defined Art-Net output.
-            return; // stop when we hit end of LEDs
-        }
 
-        hardware_output_universe = hardware_outputs_universe_start[hardware_output];
+    if (protocol == pr_ArtNet) packet[12] = sequenceNumber;
+    else if (protocol == pr_E131) packet[111]++; //0..255
+    else packet[1] = sequenceNumber % 15 + 1; //4 bits, 0 is not used
 
-        uint_fast16_t channels_remaining = hardware_outputs[hardware_output] * layerP.lights.header.channelsPerLight;
+    bool sent = false;
+    for (const ArtnetUniverse &universe: universes) {
 
-        while (channels_remaining > 0) {
-            const uint_fast16_t ARTNET_CHANNELS_PER_PACKET = 510; // 512/4=128 RGBW LEDs, 510/3=170 RGB LEDs
+        //DDP: the last packet has the push flag, so it is send if any packet before it is send
+        bool last = &universe == &universes.back();
+        if (!sendAll && !layerP.changedSince(universe.offset, universe.size, sinceFrame) && !(protocol == pr_DDP && last && sent)) continue; //unchanged
 
-            uint_fast16_t packetSize = ARTNET_CHANNELS_PER_PACKET;
+        setPacketHeader(protocol, universe, last);
 
-            if (channels_remaining < ARTNET_CHANNELS_PER_PACKET) {
-                packetSize = channels_remaining;
-                channels_remaining = 0;
-            } else {
-                channels_remaining -= packetSize;
-            }
+        //copy the channels after the header and scale the brightness in one pass
+        //to do: only correct light channels !!! (now the first 3 channels of each light)
+        const byte *channels = &layerP.lightsOut->channels[universe.offset];
+        byte *data = packet + headerSize;
+        uint8_t lightChannel = universe.lightChannel;
+        for (uint_fast16_t i = 0; i < universe.size; i++) {
+            data[i] = lightChannel < 3? scale[channels[i]]: channels[i];
+            if (++lightChannel == header.channelsPerLight) lightChannel = 0;
+        }
 
-            // set the parts of the Art-Net packet header that change:
-            packet_buffer[12] = sequenceNumber;
-            packet_buffer[14] = hardware_output_universe;
-            packet_buffer[16] = packetSize >> 8;
-            packet_buffer[17] = packetSize;
-
-            // bulk copy the buffer range to the packet buffer after the header 
-            memcpy(packet_buffer+18, (&layerP.lights.channels[0])+bufferOffset, packetSize); //start from the first byte of ledsP[0]
-
-            //no brightness scaling for the time being
-            for (int i = 18; i < packetSize+18; i+= layerP.lights.header.channelsPerLight) {
-                // set brightness all at once - seems slightly faster than scale8()?
-                // for some reason, doing 3/4 at a time is 200 micros faster than 1 at a time.
-                
-                //to do: only correct light channels !!!
-                packet_buffer[i] = (packet_buffer[i] * bri) >> 8;
-                packet_buffer[i+1] = (packet_buffer[i+1] * bri) >> 8;
-                packet_buffer[i+2] = (packet_buffer[i+2] * bri) >> 8; 
-            }
+        bool written;
+        if (protocol == pr_ArtNet)
+            written = artnetudp.writeTo(packet, headerSize + universe.size, controllerIP, ARTNET_DEFAULT_PORT);
+        else if (protocol == pr_DDP)
+            written = artnetudp.writeTo(packet, headerSize + universe.size, controllerIP, DDP_DEFAULT_PORT);
+        else if (multicast)
+            written = artnetudp.writeTo(packet, headerSize + universe.size, IPAddress(239, 255, universe.universe >> 8, universe.universe), E131_DEFAULT_PORT);
+        else
+            written = artnetudp.writeTo(packet, headerSize + universe.size, controllerIP, E131_DEFAULT_PORT);
+        if (!written) {
+            Serial.print("🐛");
+            refresh = true; //resend all next time
+            return; // borked
+        }
+        sent = true;
+    }
 
-            bufferOffset += packetSize;
-            
-            if (!artnetudp.writeTo(packet_buffer, packetSize+18, controllerIP, ARTNET_DEFAULT_PORT)) {
-                Serial.print("🐛");
-                return; // borked
+    //broadcast, so all controllers latch this frame at the same time
+    if (sync && sent && protocol == pr_ArtNet) {
+        if (!artnetudp.writeTo(ART_SYNC_PACKET, sizeof(ART_SYNC_PACKET), WiFi.broadcastIP(), ARTNET_DEFAULT_PORT)) {
+            Serial.print("🐛");
+        }
+    }
+  }   //sendFrame
+
+    //universe table: split each output in universes of max ARTNET_CHANNELS_PER_PACKET channels, up to the end of lightsOut
+    //DDP: all channels in packets of DDP_CHANNELS_PER_PACKET, the outputs are not used (the controller maps the offsets)
+    void buildUniverses(OutputProtocol protocol) {
+        const LightsHeader &header = layerP.lightsOut->header;
+        size_t nrOfChannels = header.nrOfLights * header.channelsPerLight;
+        universes.clear();
+        size_t offset = 0;
+        if (protocol == pr_DDP) {
+            for (; offset < nrOfChannels; offset += DDP_CHANNELS_PER_PACKET)
+                universes.push_back({(uint32_t)offset, (uint16_t)MIN(nrOfChannels - offset, DDP_CHANNELS_PER_PACKET), 0, (uint8_t)(offset % header.channelsPerLight), 0});
+        } else {
+            for (size_t output = 0; output < hardware_outputs.size() && offset < nrOfChannels; output++) { //loop over all outputs
+                uint16_t universe = hardware_outputs_universe_start[output] + (protocol == pr_E131? 1: 0);
+                size_t channelsRemaining = MIN(hardware_outputs[output] * header.channelsPerLight, nrOfChannels - offset); // stop when we hit end of LEDs
+                while (channelsRemaining > 0) {
+                    uint16_t size = MIN(channelsRemaining, ARTNET_CHANNELS_PER_PACKET);
+                    universes.push_back({(uint32_t)offset, size, universe++, (uint8_t)(offset % header.channelsPerLight), hardware_outputs_priority[output]});
+                    offset += size;
+                    channelsRemaining -= size;
+                }
             }
+        }
+        universesChannels = nrOfChannels;
+        universesChannelsPerLight = header.channelsPerLight;
+        ESP_LOGD(TAG, "%d universes for %d channels", universes.size(), nrOfChannels);
+    }
+
+    //the bytes of a packet which are the same for all universes and frames
+    void buildPacketTemplate(OutputProtocol protocol) {
+        memset(packet, 0, sizeof(packet));
+        if (protocol == pr_ArtNet) {
+            memcpy(packet, ART_NET_HEADER, ART_NET_HEADER_SIZE); // copy in the Art-Net header.
+            headerSize = ART_NET_HEADER_SIZE + 6;
+        } else if (protocol == pr_E131) {
+            memcpy(packet, E131_ROOT_HEADER, sizeof(E131_ROOT_HEADER));
+            //CID: unique per sender, "MoonLight" and the mac address
+            memcpy(packet + 22, "MoonLight", 9);
+            esp_read_mac(packet + 32, ESP_MAC_WIFI_STA);
+            packet[43] = 0x02; //framing layer: VECTOR_E131_DATA_PACKET
+            strncpy((char *)packet + 44, "MoonLight", 64); //source name
+            memcpy(packet + 115, E131_DMP_HEADER, sizeof(E131_DMP_HEADER));
+            headerSize = E131_HEADER_SIZE; //start code 0 at 125
+        } else {
+            packet[3] = 1; //destination: default output device
+            headerSize = DDP_HEADER_SIZE;
+        }
+        universesChannels = 0; //universe numbers depend on the protocol
+    }
 
-            hardware_output_universe++;
+    //the bytes of a packet which depend on the universe (the sequence number is set once per frame)
+    void setPacketHeader(OutputProtocol protocol, const ArtnetUniverse &universe, bool last) {
+        if (protocol == pr_ArtNet) {
+            packet[14] = universe.universe; //SubUni
+            packet[15] = universe.universe >> 8; //Net
+            packet[16] = universe.size >> 8;
+            packet[17] = universe.size;
+        } else if (protocol == pr_DDP) {
+            packet[0] = last? 0x41: 0x40; //version 1, push: show the frame after the last packet
+            packet[2] = universesChannelsPerLight == 4? 0x1B: 0x0B; //data type RGBW or RGB, 8 bits per channel
+            packet[4] = universe.offset >> 24;
+            packet[5] = universe.offset >> 16;
+            packet[6] = universe.offset >> 8;
+            packet[7] = universe.offset;
+            packet[8] = universe.size >> 8;
+            packet[9] = universe.size;
+        } else {
+            uint16_t length = E131_HEADER_SIZE + universe.size;
+            //flags and length of each layer: 0x7 in the top nibble, length from the start of the layer
+            packet[16] = 0x70 | (length - 16) >> 8; packet[17] = length - 16; //root
+            packet[38] = 0x70 | (length - 38) >> 8; packet[39] = length - 38; //framing
+            packet[115] = 0x70 | (length - 115) >> 8; packet[116] = length - 115; //DMP
+            packet[108] = universe.priority;
+            packet[113] = universe.universe >> 8;
+            packet[114] = universe.universe;
+            packet[123] = (universe.size + 1) >> 8; //property value count: start code and channels
+            packet[124] = universe.size + 1;
         }
     }
-  }   //loop20ms
 };
 
 #endif
@@ -0,0 +1,239 @@
+/**
+    @title     MoonBase
+    @file      ModuleArtnetIn.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/moonbase/module/artnetin/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+#ifndef ModuleArtnetIn_h
+#define ModuleArtnetIn_h
+
+#if FT_MOONBASE == 1
+
+#include "ModuleArtnet.h" //protocol definitions
+
+#include <atomic>
+
+//network input: Art-Net, E1.31 or DDP (e.g. from a media server) is written into the lights instead of the effects
+//the AsyncUDP task writes the channels of each packet directly into layerP.lights, the render task outputs the frame when it is complete
+//layerP.lights is not double buffered for the input: if the render task copies it (copyToLightsOut) while packets of the next frame arrive,
+//the output can show parts of two frames (tearing), acceptable as the next frame follows within a frame time
+class ModuleArtnetIn : public Module
+{
+public:
+
+    //settings, set by the HTTP task (onUpdate), receive uses them after the next reset (see resetPending)
+    bool on = false;
+    OutputProtocol protocol = pr_ArtNet;
+    uint16_t startUniverse = 0; //Art-Net universe written at the first channel (E1.31: startUniverse + 1)
+    uint16_t universeSize = ARTNET_CHANNELS_PER_PACKET; //channels per universe: universe n starts at channel (n - startUniverse) * universeSize
+
+    AsyncUDP udp;
+    //receive state: only used by the AsyncUDP task (receive), the HTTP task (listen, onUpdate) sets resetPending to have it reset there
+    std::atomic<bool> resetPending = true; //set after the settings are changed, so receive copies the new settings
+    OutputProtocol receiveProtocol = pr_ArtNet; //the settings receive uses
+    uint16_t receiveStartUniverse = 0;
+    uint16_t receiveUniverseSize = ARTNET_CHANNELS_PER_PACKET;
+    bool syncSeen = false; //the sender sends ArtSync, E1.31 sync or DDP push: a frame is complete at the sync, not at the last universe
+    bool framePending = false; //lights written since the last complete frame
+    unsigned long frameStart = 0; //micros of the first packet of the pending frame
+    std::vector<int16_t> sequences; //last sequence number per universe (DDP: per DDP_CHANNELS_PER_PACKET), -1: none yet
+
+    //statistics of the last second, counted by the AsyncUDP task, read and reset by loop1s
+    std::atomic<uint32_t> packets = 0;
+    std::atomic<uint32_t> framesReceived = 0;
+    std::atomic<uint32_t> lost = 0; //skipped sequence numbers
+    std::atomic<uint32_t> latencyMicros = 0; //first packet of a frame until the frame is handed to the render task
+
+    ModuleArtnetIn(PsychicHttpServer *server,
+            ESP32SvelteKit *sveltekit,
+            FilesService *filesService
+        ) : Module("artnetin", server, sveltekit, filesService) {
+            ESP_LOGD(TAG, "constructor");
+    }
+
+    void setupDefinition(JsonArray root) override{
+        ESP_LOGD(TAG, "");
+        JsonObject property; // state.data has one or more properties
+        JsonArray values; // if a property is a select, this is the values of the select
+
+        property = root.add<JsonObject>(); property["name"] = "on"; property["type"] = "checkbox"; property["default"] = false;
+        property = root.add<JsonObject>(); property["name"] = "protocol"; property["type"] = "select"; property["default"] = "Art-Net"; values = property["values"].to<JsonArray>();
+        values.add("Art-Net");
+        values.add("E1.31");
+        values.add("DDP");
+        property = root.add<JsonObject>(); property["name"] = "universe"; property["type"] = "number"; property["default"] = 0; property["min"] = 0; property["max"] = 32767;
+        property = root.add<JsonObject>(); property["name"] = "universeSize"; property["type"] = "number"; property["default"] = ARTNET_CHANNELS_PER_PACKET; property["min"] = 1; property["max"] = 512;
+        property = root.add<JsonObject>(); property["name"] = "status"; property["type"] = "text"; property["ro"] = true;
+    }
+
+    void onUpdate(UpdatedItem &updatedItem) override
+    {
+        if (equal(updatedItem.name, "on")) {
+            on = updatedItem.value;
+            listen();
+        }
+        else if (equal(updatedItem.name, "protocol")) {
+            if (updatedItem.value == "E1.31") protocol = pr_E131;
+            else if (updatedItem.value == "DDP") protocol = pr_DDP;
+            else protocol = pr_ArtNet;
+            listen();
+        }
+        else if (equal(updatedItem.name, "universe")) {
+            startUniverse = updatedItem.value;
+            resetPending = true;
+        }
+        else if (equal(updatedItem.name, "universeSize")) {
+            universeSize = MAX(updatedItem.value.as<int>(), 1);
+            resetPending = true; //other offsets: start again
+        }
+        else
+            ESP_LOGD(TAG, "no handle for %s[%d]%s[%d].%s = %s -> %s", updatedItem.parent[0], updatedItem.index[0], updatedItem.parent[1], updatedItem.index[1], updatedItem.name, updatedItem.oldValue.c_str(), updatedItem.value.as<String>().c_str());
+    }
+
+    //(re)open the port of the protocol, the effects pause while receiving
+    void listen() {
+        udp.close();
+        resetPending = true; //receive can still run for a packet of the closed port
+        layerP.receiving = on;
+        if (!on) return;
+
+        uint16_t port = protocol == pr_E131? E131_DEFAULT_PORT: protocol == pr_DDP? DDP_DEFAULT_PORT: ARTNET_DEFAULT_PORT;
+        if (udp.listen(port)) {
+            udp.onPacket([this](AsyncUDPPacket packet) {
+                receive(packet.data(), packet.length());
+            });
+            ESP_LOGD(TAG, "listening on %d", port);
+        } else
+            ESP_LOGW(TAG, "listen on %d failed", port);
+    }
+
+    //called by the AsyncUDP task for each packet
+    void receive(const uint8_t *data, size_t length) {
+        packets++;
+
+        if (resetPending.exchange(false)) {
+            receiveProtocol = protocol;
+            receiveStartUniverse = startUniverse;
+            receiveUniverseSize = universeSize;
+            syncSeen = false;
+            framePending = false;
+            sequences.clear();
+        }
+
+        const uint8_t *channels = nullptr; //in the packet
+        size_t size = 0;
+        size_t offset = 0; //in lights
+        bool frameEnd = false; //sync packet or last packet of the frame
+
+        if (receiveProtocol == pr_ArtNet) {
+            if (length < ART_NET_HEADER_SIZE || memcmp(data, ART_NET_HEADER, 8) != 0) return;
+            uint16_t opCode = data[8] | data[9] << 8;
+            if (opCode == 0x5000 && length >= ART_NET_HEADER_SIZE + 6) { //OpDmx
+                uint16_t universe = data[14] | data[15] << 8;
+                if (universe < receiveStartUniverse) return;
+                if (data[12]) countLost(universe - receiveStartUniverse, data[12] - 1, 255); //1..255, 0: not used
+                offset = (size_t)(universe - receiveStartUniverse) * receiveUniverseSize;
+                size = MIN(MIN((size_t)(data[16] << 8 | data[17]), length - 18), (size_t)receiveUniverseSize);
+                channels = data + 18;
+                frameEnd = !syncSeen && isLastUniverse(offset);
+            } else if (opCode == 0x5200) { //OpSync
+                syncSeen = true;
+                frameEnd = true;
+            }
+        } else if (receiveProtocol == pr_E131) {
+            if (length < 49 || memcmp(data + 4, E131_ROOT_HEADER + 4, 12) != 0) return; //49: synchronization packet
+            if (data[21] == 0x04 && length >= E131_HEADER_SIZE && data[43] == 0x02 && data[117] == 0x02 && data[125] == 0) { //data packet, start code 0
+                uint16_t universe = data[113] << 8 | data[114];
+                if (universe <= receiveStartUniverse) return;
+                countLost(universe - 1 - receiveStartUniverse, data[111], 256);
+                offset = (size_t)(universe - 1 - receiveStartUniverse) * receiveUniverseSize;
+                size = MIN(MIN((size_t)(data[123] << 8 | data[124]) - 1, length - E131_HEADER_SIZE), (size_t)receiveUniverseSize);
+                channels = data + E131_HEADER_SIZE;
+                if (data[109] || data[110]) syncSeen = true; //synchronization address: wait for the sync packet
+                frameEnd = !syncSeen && isLastUniverse(offset);
+            } else if (data[21] == 0x08 && data[43] == 0x01) { //synchronization packet
+                syncSeen = true;
+                frameEnd = true;
+            }
+        } else {
+            if (length < DDP_HEADER_SIZE || (data[0] & 0xC0) != 0x40) return; //version 1
+            size_t headerSize = data[0] & 0x10? DDP_HEADER_SIZE + 4: DDP_HEADER_SIZE; //timecode
+            if (length < headerSize) return;
+            offset = (uint32_t)data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7];
+            if (data[1] & 0x0F) countLost(offset / DDP_CHANNELS_PER_PACKET, (data[1] & 0x0F) - 1, 15); //1..15, 0: not used
+            size = MIN((size_t)(data[8] << 8 | data[9]), length - headerSize);
+            channels = data + headerSize;
+            if (data[0] & 0x01) syncSeen = true; //push
+            frameEnd = syncSeen? data[0] & 0x01: offset + size >= layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight;
+        }
+
+        if (channels && size) {
+            //not while a mapping resizes the lights (packet dropped)
+            if (layerP.lights.header.type != ct_Leds || xSemaphoreTake(layerP.mappingMutex, 0) != pdTRUE) return;
+            size_t nrOfChannels = MIN(layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight, layerP.lights.maxChannels);
+            if (offset < nrOfChannels) {
+                //the render task can copy the lights meanwhile (no lock there), see the class comment
+                memcpy(&layerP.lights.channels[offset], channels, MIN(size, nrOfChannels - offset));
+                if (!framePending) {
+                    framePending = true;
+                    frameStart = micros();
+                }
+            }
+            xSemaphoreGive(layerP.mappingMutex);
+        }
+
+        if (frameEnd && framePending) {
+            framePending = false;
+            framesReceived++;
+            latencyMicros += micros() - frameStart;
+            xSemaphoreGive(layerP.frameReceived); //the render task outputs the frame
+        }
+    }
+
+    //true if the universe at offset contains the last channel of the lights
+    bool isLastUniverse(size_t offset) {
+        size_t nrOfChannels = layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight;
+        return offset < nrOfChannels && offset + receiveUniverseSize >= nrOfChannels;
+    }
+
+    //sequence numbers skipped since the previous packet of the same universe, sequence 0..range-1
+    void countLost(size_t universe, int sequence, int range) {
+        if (universe >= sequences.size()) {
+            if (universe >= 1024) return; //not a universe of the lights
+            sequences.resize(universe + 1, -1);
+        }
+        int previous = sequences[universe];
+        sequences[universe] = sequence;
+        if (previous < 0) return;
+        int gap = (sequence - previous + range) % range;
+        if (gap > 1 && gap < range / 2) lost += gap - 1; //bigger gaps: reordered packet or sender restarted
+    }
+
+    //update the status in the UI
+    void loop1s() {
+        if (!on) return;
+
+        Char<96> stats;
+        //exchange: counts added by the AsyncUDP task between the read and the reset are not lost
+        uint32_t nrOfPackets = packets.exchange(0);
+        uint32_t nrOfFrames = framesReceived.exchange(0);
+        uint32_t nrLost = lost.exchange(0);
+        uint32_t latency = latencyMicros.exchange(0);
+        stats.format("%d packets/s, %d frames/s, %d lost, latency %.1fms", nrOfPackets, nrOfFrames, nrLost, nrOfFrames?latency / 1000.0f / nrOfFrames:0);
+
+        if (!_socket->getConnectedClients()) return;
+
+        JsonDocument newData; //to only send updatedData
+        newData["status"] = String(stats.c_str()); //read only: only send, not in the state as that is written to file
+        JsonObject newDataObject = newData.as<JsonObject>();
+        _socket->emitEvent("artnetin", newDataObject);
+    }
+};
+
+#endif
+#endif
@@ -0,0 +1,111 @@
+/**
+    @title     MoonLight
+    @file      MoonMath.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+#if FT_MOONLIGHT
+
+#include "MoonMath.h"
+
+//sin(i/64 * π/2) * 32767
+static const int16_t sinTable[65] PROGMEM = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767};
+
+//atan(i/64) in angles (65536 is a full circle)
+static const uint16_t atanTable[65] PROGMEM = {
+  0, 163, 326, 489, 651, 813, 975, 1136, 1297, 1457, 1617, 1775, 1933, 2090, 2246, 2401,
+  2555, 2708, 2860, 3010, 3159, 3307, 3453, 3599, 3742, 3884, 4025, 4164, 4302, 4438, 4572, 4705,
+  4836, 4966, 5094, 5220, 5344, 5467, 5589, 5708, 5826, 5943, 6058, 6171, 6282, 6392, 6500, 6607,
+  6712, 6815, 6917, 7018, 7117, 7214, 7310, 7405, 7498, 7589, 7679, 7768, 7856, 7942, 8026, 8110,
+  8192};
+
+int16_t sinQ15(uint16_t angle) {
+  uint16_t quarter = angle & 0x3FFF; //angle in the quadrant, 0..16383
+  if (angle & 0x4000) quarter = 0x4000 - quarter; //2nd and 4th quadrant: mirrored, 1..16384
+  int16_t value;
+  if (quarter == 0x4000)
+    value = 32767;
+  else {
+    uint8_t index = quarter >> 8;
+    value = sinTable[index] + (((sinTable[index + 1] - sinTable[index]) * (quarter & 0xFF)) >> 8);
+  }
+  return (angle & 0x8000)? -value: value; //3rd and 4th quadrant: negative
+}
+
+uint16_t atan2Angle(int16_t y, int16_t x) {
+  if (x == 0 && y == 0) return 0;
+  uint32_t absX = abs(x);
+  uint32_t absY = abs(y);
+  //first octant: ratio 0..1 in 16 bits fraction
+  bool swap = absY > absX;
+  uint32_t ratio = swap? (absX << 16) / absY: (absY << 16) / absX;
+  uint16_t angle;
+  if (ratio >= 65536)
+    angle = 8192;
+  else {
+    uint8_t index = ratio >> 10;
+    angle = atanTable[index] + (((atanTable[index + 1] - atanTable[index]) * (ratio & 0x3FF)) >> 10);
+  }
+  if (swap) angle = 16384 - angle; //45..90 degrees
+  if (x < 0) angle = 32768 - angle; //2nd and 3rd quadrant
+  if (y < 0) angle = -angle; //3rd and 4th quadrant
+  return angle;
+}
+
+uint32_t sqrt32(uint32_t value) {
+  uint32_t result = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > value) bit >>= 2;
+  while (bit) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else
+      result >>= 1;
+    bit >>= 2;
+  }
+  return result;
+}
+
+void hueTable(CRGB *table, uint8_t sat, uint8_t val) {
+  for (int hue = 0; hue < 256; hue++) table[hue] = CHSV(hue, sat, val);
+}
+
+const char * const paletteNames[NR_OF_PALETTES] = {"Party", "Cloud", "Lava", "Ocean", "Forest", "Rainbow", "RainbowStripe", "Heat"};
+static const TProgmemRGBPalette16 * const paletteValues[NR_OF_PALETTES] = {&PartyColors_p, &CloudColors_p, &LavaColors_p, &OceanColors_p, &ForestColors_p, &RainbowColors_p, &RainbowStripeColors_p, &HeatColors_p};
+
+const TProgmemRGBPalette16 *findPalette(const char *name) {
+  for (int i = 0; i < NR_OF_PALETTES; i++) {
+    if (strcmp(paletteNames[i], name) == 0) return paletteValues[i];
+  }
+  return paletteValues[0];
+}
+
+bool PaletteLUT::update(const TProgmemRGBPalette16 *palette) {
+  if (!colors) {
+    colors = (CRGB *)malloc(256 * sizeof(CRGB));
+    if (!colors) {
+      ESP_LOGW(TAG, "no memory for palette");
+      return false;
+    }
+    this->palette = nullptr;
+  }
+  if (palette != this->palette) {
+    CRGBPalette16 expanded = *palette; //out of PROGMEM once
+    for (int index = 0; index < 256; index++) colors[index] = ColorFromPalette(expanded, index);
+    this->palette = palette;
+  }
+  return true;
+}
+
+#endif //FT_MOONLIGHT
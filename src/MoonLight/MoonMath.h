@@ -0,0 +1,74 @@
+/**
+    @title     MoonLight
+    @file      MoonMath.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+#pragma once
+
+#if FT_MOONLIGHT
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+//fixed point math for effects: no float in per light loops (the ESP32 FPU is slow on division, sqrt and trigonometry)
+
+typedef int16_t q8_8; //fixed point, 8 bits fraction: 1.0 is 256
+typedef int32_t q16_16; //fixed point, 16 bits fraction: 1.0 is 65536
+
+#define Q8_8(f) ((q8_8)((f) * 256.0f)) //for constants
+#define Q16_16(f) ((q16_16)((f) * 65536.0f))
+
+inline q8_8 mulQ8_8(q8_8 a, q8_8 b) {return ((int32_t)a * b) >> 8;}
+inline q8_8 divQ8_8(q8_8 a, q8_8 b) {return ((int32_t)a << 8) / b;}
+inline q16_16 mulQ16_16(q16_16 a, q16_16 b) {return ((int64_t)a * b) >> 16;}
+inline q16_16 divQ16_16(q16_16 a, q16_16 b) {return ((int64_t)a << 16) / b;}
+inline int floorQ16_16(q16_16 a) {return a >> 16;}
+inline int roundQ16_16(q16_16 a) {return (a + 32768) >> 16;}
+
+//angles are uint16_t, 65536 is a full circle (as FastLED sin16)
+#define ANGLE_PER_RADIAN 10430.378f //65536 / 2π
+
+//sine and cosine, -32767..32767, quarter wave table with interpolation (max error 4 of 32767)
+int16_t sinQ15(uint16_t angle);
+inline int16_t cosQ15(uint16_t angle) {return sinQ15(angle + 16384);}
+
+//angle of (x, y) from the x axis, 0..65535, table with interpolation (max error 2 of 65536)
+uint16_t atan2Angle(int16_t y, int16_t x);
+
+//floor of the square root, exact
+uint32_t sqrt32(uint32_t value);
+
+inline uint32_t distanceSquared(int dx, int dy, int dz) {return dx * dx + dy * dy + dz * dz;}
+
+//HSV to RGB for spans of lights with the same saturation and value: make a table of 256 CRGB once (e.g. in the node arena), then one lookup per light
+//colors as CRGB(CHSV(hue, sat, val)), FastLED rainbow
+void hueTable(CRGB *table, uint8_t sat, uint8_t val);
+inline void hsv2rgbSpan(const CRGB *table, const uint8_t *hues, CRGB *colors, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) colors[i] = table[hues[i]];
+}
+
+//the palettes of a palette control (see Node::addPaletteControl), FastLED built in palettes
+#define NR_OF_PALETTES 8
+extern const char * const paletteNames[NR_OF_PALETTES];
+const TProgmemRGBPalette16 *findPalette(const char *name); //Party if not found
+
+//a palette expanded to 256 colors: colors[index] is ColorFromPalette(palette, index), no interpolation per light
+//full brightness only: a brightness per light is applied to the looked up color (e.g. nscale8_video), so the table is not rebuilt per light
+struct PaletteLUT {
+  CRGB *colors = nullptr; //256, allocated at the first update
+  const TProgmemRGBPalette16 *palette = nullptr; //of colors
+
+  ~PaletteLUT() {free(colors);}
+
+  //call before the lookups (e.g. once per frame): expands the palette only if it changed, false if no memory
+  bool update(const TProgmemRGBPalette16 *palette);
+  const CRGB &operator[](uint8_t index) const {return colors[index];}
+};
+
+#endif //FT_MOONLIGHT
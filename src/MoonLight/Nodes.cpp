@@ -13,6 +13,107 @@
 #if FT_MOONLIGHT
 #include "Nodes.h"
 
+bool NodeArena::reserve(size_t size) {
+  release();
+  //large scratch in PSRAM if available, so it does not fragment the internal heap
+  if (size >= 1024 && psramFound()) data = (byte *)heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!data) data = (byte *)heap_caps_calloc(1, size, MALLOC_CAP_8BIT);
+  if (!data) {
+    ESP_LOGW(TAG, "no memory for arena of %d bytes", size);
+    return false;
+  }
+  this->size = size;
+  return true;
+}
+
+void NodeArena::release() {
+  free(data);
+  data = nullptr;
+  size = 0;
+  used = 0;
+}
+
+//fixed size slots for nodes, chunks of slots are allocated when needed and kept, freed slots are reused by the next node
+//nodes are only created and deleted in onUpdate (one task at a time)
+struct NodePool {
+  std::vector<byte *> chunks;
+  void *freeSlots = nullptr; //linked list, the first bytes of a free slot point to the next free slot
+
+  void *alloc() {
+    if (!freeSlots) {
+      byte *chunk = (byte *)malloc(NODE_SLOT_SIZE * NODE_POOL_CHUNK);
+      if (!chunk) return nullptr;
+      chunks.push_back(chunk);
+      for (int i = NODE_POOL_CHUNK - 1; i >= 0; i--) release(chunk + i * NODE_SLOT_SIZE);
+      ESP_LOGD(TAG, "node pool %d slots", chunks.size() * NODE_POOL_CHUNK);
+    }
+    void *slot = freeSlots;
+    freeSlots = *(void **)slot;
+    return slot;
+  }
+
+  void release(void *slot) {
+    *(void **)slot = freeSlots;
+    freeSlots = slot;
+  }
+
+  bool contains(void *pointer) {
+    for (byte *chunk: chunks) {
+      if (pointer >= chunk && pointer < chunk + NODE_SLOT_SIZE * NODE_POOL_CHUNK) return true;
+    }
+    return false;
+  }
+};
+
+static NodePool nodePool;
+
+void *Node::operator new(size_t size) {
+  void *node = size <= NODE_SLOT_SIZE?nodePool.alloc():nullptr;
+  if (!node) {
+    if (size > NODE_SLOT_SIZE) ESP_LOGW(TAG, "node of %d bytes does not fit in a slot of %d, move state to the arena", size, NODE_SLOT_SIZE);
+    node = malloc(size);
+  }
+  return node;
+}
+
+void Node::operator delete(void *pointer) {
+  if (nodePool.contains(pointer))
+    nodePool.release(pointer);
+  else
+    free(pointer);
+}
+
+const NodeType nodeTypes[] = {
+  NODE_TYPE(SolidEffect, "Solid🔥", nk_effect),
+  //alphabetically from here
+  NODE_TYPE(BouncingBallsEffect, "BouncingBalls🔥", nk_effect),
+  NODE_TYPE(LinesEffect, "Lines🔥", nk_effect),
+  NODE_TYPE(LissajousEffect, "Lissajous🔥", nk_effect),
+  NODE_TYPE(MovingHeadEffect, "MovingHead🔥", nk_effect),
+  NODE_TYPE(RainbowEffect, "Rainbow🔥", nk_effect),
+  NODE_TYPE(RandomEffect, "Random🔥", nk_effect),
+  NODE_TYPE(RipplesEffect, "RipplesEffect🔥", nk_effect),
+  NODE_TYPE(RGBWParEffect, "RGBWPar🔥", nk_effect),
+  NODE_TYPE(SinelonEffect, "Sinelon🔥", nk_effect),
+  NODE_TYPE(SinusEffect, "Sinus🔥", nk_effect),
+  NODE_TYPE(SphereMoveEffect, "SphereMoveEffect🔥", nk_effect),
+  NODE_TYPE(DMXLayout, "DMX🚥", nk_layout),
+  NODE_TYPE(PanelLayout, "Panel🚥", nk_layout),
+  NODE_TYPE(RingsLayout, "Rings🚥", nk_layout),
+  NODE_TYPE(MirrorModifier, "Mirror💎", nk_modifier),
+  NODE_TYPE(MultiplyModifier, "Multiply💎", nk_modifier),
+  NODE_TYPE(PinwheelModifier, "Pinwheel💎", nk_modifier),
+};
+const size_t nrOfNodeTypes = sizeof(nodeTypes) / sizeof(NodeType);
+
+const NodeType *findNodeType(const char *animation) {
+  uint32_t hash = hashString(animation);
+  for (size_t i = 0; i < nrOfNodeTypes; i++) {
+    if (nodeTypes[i].hash == hash && equal(nodeTypes[i].animation, animation)) return &nodeTypes[i];
+  }
+  return nullptr;
+}
+
 #if FT_LIVESCRIPT
 
 #define USE_FASTLED //as ESPLiveScript.h calls hsv ! one of the reserved functions!!
@@ -32,7 +133,13 @@ static void _modifyLayout() {gNode->modifyLayout();}
 
 void _fadeToBlackBy(uint8_t fadeValue) { gNode->layerV->fadeToBlackBy(fadeValue);}
 static void _sLC(uint16_t indexV, CRGB color) {gNode->layerV->setLightColor(indexV, color);}
-static void _sCFP(uint16_t indexV, uint8_t index, uint8_t brightness) { gNode->layerV->setLightColor(indexV, ColorFromPalette(PartyColors_p, index, brightness));}
+static void _sCFP(uint16_t indexV, uint8_t index, uint8_t brightness) {
+  LiveScriptNode *node = (LiveScriptNode *)gNode;
+  if (!node->lut.update(node->currentPalette)) return;
+  CRGB color = node->lut[index];
+  if (brightness != 255) color.nscale8_video(brightness); //as ColorFromPalette: 0 only if brightness or the channel is 0
+  node->layerV->setLightColor(indexV, color);
+}
 
 static float _triangle(float j) {return 1.0 - fabs(fmod(2 * j, 2.0) - 1.0);}
 static float _time(float j) {
@@ -232,9 +339,13 @@ void LiveScriptNode::execute() {
 }
 
 void LiveScriptNode::map() {
-    if (hasLayout) {
-        for (layerV->layerP->pass = 1; layerV->layerP->pass <= 2; layerV->layerP->pass++)
-            scriptRuntime.execute(animation, "map"); 
+    if (hasLayout && !layerV->layerP->mappingDeferred) {
+        mapTiming.reset();
+        for (layerV->layerP->pass = 1; layerV->layerP->pass <= 2; layerV->layerP->pass++) {
+            uint32_t start = ESP.getCycleCount();
+            layerV->layerP->mapPass([this]() {scriptRuntime.execute(animation, "map");}); //the script calls addLayoutPre, addLight and addLayoutPost
+            mapTiming.add(ESP.getCycleCount() - start);
+        }
     }
 }
 
@@ -284,6 +395,7 @@ void LiveScriptNode::addControls(JsonArray controls)  {
     addControl(controls, &custom1, "custom1", "range", 128);
     addControl(controls, &custom2, "custom2", "range", 128);
     addControl(controls, &custom3, "custom3", "range", 128);
+    addPaletteControl(controls, palette);
     
     //if (exist addControls) scriptRuntime.execute(animation, "addControls"); 
     //
@@ -309,6 +421,7 @@ void LiveScriptNode::addControls(JsonArray controls)  {
   
   void LiveScriptNode::updateControl(JsonObject control)  {
     Node::updateControl(control); //call base class
+    currentPalette = findPalette(palette);
 
     //if changed run setup needed??? (todo: if hasLayout then rerun mapping needed ..., if modifier then done by ModuleAnimations...)
     // setup();
@@ -21,6 +21,48 @@
 
 #include <ESPFS.h>
 
+//min, average and max duration (in cpu cycles) of calls to a node function, since the last reset
+struct NodeTiming {
+  uint32_t min = UINT32_MAX;
+  uint32_t max = 0;
+  uint32_t total = 0;
+  uint32_t count = 0;
+
+  void add(uint32_t cycles) {
+    if (cycles < min) min = cycles;
+    if (cycles > max) max = cycles;
+    total += cycles;
+    count++;
+  }
+  void reset() {*this = NodeTiming();}
+};
+
+#define NODE_SLOT_SIZE 160 //bytes, nodes are allocated in slots of this size (see NodePool in Nodes.cpp), bigger state should go in the arena
+#define NODE_POOL_CHUNK 16 //nr of slots allocated at once when all slots are in use
+
+//scratch memory of a node (e.g. state per row or per light), sized at runtime (e.g. to layerV->size) instead of to a compile time maximum
+//one block: reserve allocates it (and releases all previous allocs), alloc hands out parts of it, all is freed at once when the node is deleted
+struct NodeArena {
+  byte *data = nullptr;
+  size_t size = 0;
+  size_t used = 0;
+
+  ~NodeArena() {release();}
+
+  bool reserve(size_t size);
+  void release();
+
+  //nullptr if the reserved size is used
+  template <typename T>
+  T *alloc(size_t count) {
+    size_t bytes = (count * sizeof(T) + 3) & ~3; //keep the next alloc 4 byte aligned
+    if (!data || used + bytes > size) return nullptr;
+    T *result = (T *)(data + used);
+    used += bytes;
+    return result;
+  }
+};
+
 class Node {
 public:
   VirtualLayer *layerV = nullptr; //the virtual layer this effect is using
@@ -30,9 +72,24 @@ public:
   bool hasLoop = false; //equal to hasEffect?
   bool hasModifier = false;
   bool hasLayout = false; //Mapper?
+  bool hasSlices = false; //effect renders in loopSlice, slices can run in parallel on both cores, see PhysicalLayer::loopSlices
 
   bool on = false; //onUpdate will set it on
 
+  //telemetry, see ModuleAnimations::loop1s
+  NodeTiming loopTiming; //loop and loopSlice, reset each second
+  NodeTiming mapTiming; //addLayout of a layout in pass 1 and 2, reset in pass 1
+  NodeTiming modifyTiming; //modifyLight of a modifier for each light, reset each mapping
+  int32_t heapSize = 0; //heap used when the node was created (new, constructor and setup), approximately as other tasks can allocate at the same time
+
+  NodeArena arena; //scratch memory, freed when the node is deleted
+
+  //nodes are allocated from NodePool so creating and deleting nodes does not fragment the heap
+  static void *operator new(size_t size);
+  static void operator delete(void *pointer);
+  //nodes are deleted as Node * (PhysicalLayer::removeNode): virtual so members of derived nodes (e.g. PaletteLUT) are destructed too
+  virtual ~Node() {}
+
   //C++ constructor and destructor are not inherited, so declare it as normal functions
   virtual void constructor(VirtualLayer *layerV, const char *animation) {
     this->layerV = layerV;
@@ -86,6 +143,14 @@ public:
     return control;
   };
 
+  //select control with the palette names (see findPalette), palette is a char[16]
+  JsonObject addPaletteControl(JsonArray controls, char *palette) {
+    JsonObject control = addControl(controls, palette, "palette", "select", paletteNames[0], 1, 16);
+    JsonArray values = control["values"].to<JsonArray>();
+    for (int i = 0; i < NR_OF_PALETTES; i++) values.add(paletteNames[i]);
+    return control;
+  }
+
   virtual void updateControl(JsonObject control) {
     if (!control["name"].isNull() && !control["type"].isNull() && !control["p"].isNull()) { //name and type can be null if controll is removed in compareRecursive
       ESP_LOGD(TAG, "%s = %s %s %s", control["name"].as<String>().c_str(), control["value"].as<String>().c_str(), control["type"].as<String>().c_str(), control["p"].as<String>().c_str());
@@ -125,6 +190,11 @@ public:
   //effect and modifier
   virtual void loop() {}
 
+  //effect with hasSlices: loop prepares the frame (e.g. fade, time), loopSlice renders slice of nrOfSlices, slices must write disjoint lights
+  virtual void loopSlice(uint8_t slice, uint8_t nrOfSlices) {}
+  //first of n items (e.g. lights, rows, planes) in slice, the slice ends before sliceStart(n, slice + 1, nrOfSlices)
+  static uint16_t sliceStart(uint16_t n, uint8_t slice, uint8_t nrOfSlices) {return (uint32_t)n * slice / nrOfSlices;}
+
   //layout
   virtual void map() {}
 
@@ -145,6 +215,10 @@ class LiveScriptNode: public Node {
   uint8_t custom1 = 128;
   uint8_t custom2 = 128;
   uint8_t custom3 = 128;
+  char palette[16] = "Party";
+
+  PaletteLUT lut; //of sCFP, updated in the script task
+  const TProgmemRGBPalette16 *currentPalette = &PartyColors_p; //set in updateControl, not per sCFP
 
   const char * name() override {return "LiveScriptNode";}
 
@@ -176,4 +250,30 @@ class LiveScriptNode: public Node {
 
 #include "Modifiers.h"
 
+enum NodeKind {
+  nk_effect,   //🔥
+  nk_layout,   //🚥
+  nk_modifier, //💎
+  nk_count
+};
+
+//a node class which can be selected in the UI, see nodeTypes
+struct NodeType {
+  const char *animation; //name in the UI
+  NodeKind kind; //sets hasLayout or hasModifier of the created node, see PhysicalLayer::addNode
+  uint32_t hash; //hashString(animation), compare this first in findNodeType
+  Node *(*create)();
+};
+
+template <class T>
+Node *newNode() {return new T();}
+
+#define NODE_TYPE(T, animation, kind) {animation, kind, hashString(animation), newNode<T>}
+
+//all node classes, the animation values in the UI (ModuleAnimations::setupDefinition) and the factory (PhysicalLayer::addNode) use this
+extern const NodeType nodeTypes[];
+extern const size_t nrOfNodeTypes;
+//nullptr if not a node class (e.g. a live script)
+const NodeType *findNodeType(const char *animation);
+
 #endif //FT_MOONLIGHT
\ No newline at end of file
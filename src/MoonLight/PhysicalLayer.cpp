@@ -17,10 +17,40 @@
 
 #include "Nodes.h"
 
+bool Lights::alloc(size_t nrOfChannels) {
+    if (channels && nrOfChannels == maxChannels) return true;
+
+    byte *buffer = channels?channels - sizeof(LightsHeader):nullptr;
+    size_t size = sizeof(LightsHeader) + nrOfChannels;
+
+    byte *newBuffer = nullptr;
+    //small setups in internal RAM (fastest), large setups in PSRAM
+    if (nrOfChannels > MAX_CHANNELS_INTERNAL && psramFound())
+        newBuffer = (byte *)heap_caps_realloc(buffer, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!newBuffer)
+        newBuffer = (byte *)heap_caps_realloc(buffer, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!newBuffer) {
+        ESP_LOGW(TAG, "no memory for %d channels (%d)", nrOfChannels, maxChannels);
+        return false; //old buffer is kept
+    }
+
+    if (nrOfChannels > maxChannels) //clear the new channels
+        memset(newBuffer + sizeof(LightsHeader) + maxChannels, 0, nrOfChannels - maxChannels);
+    if (buffer && newBuffer != buffer) ESP_LOGD(TAG, "lights moved");
+
+    channels = newBuffer + sizeof(LightsHeader);
+    maxChannels = nrOfChannels;
+    ESP_LOGD(TAG, "channels %d", maxChannels);
+    return true;
+}
+
 PhysicalLayer::PhysicalLayer() {
         ESP_LOGD(TAG, "constructor");
 
         lights.header.type = ct_Leds;
+        mappingMutex = xSemaphoreCreateMutex();
+        lightsOutMutex = xSemaphoreCreateMutex();
+        frameReceived = xSemaphoreCreateBinary();
 
         // initLightsToBlend();
 
@@ -38,45 +68,182 @@ PhysicalLayer::PhysicalLayer() {
 
     //run one loop of an effect
     bool PhysicalLayer::loop() {
+        //wait if a mapping is build
+        if (xSemaphoreTake(mappingMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            ESP_LOGW(TAG, "mapping not ready, frame skipped");
+            return false;
+        }
+        if (lights.header.type != ct_Leds) { //layout changed while waiting, wait for pass 2
+            xSemaphoreGive(mappingMutex);
+            return false;
+        }
         //runs the loop of all effects / nodes in the layer
+        unsigned long start = micros();
         for (VirtualLayer * layer: layerV) {
             if (layer) layer->loop(); //if (layer) needed when deleting rows ...
         }
+        effectsMicros += micros() - start;
+        if (layerV.size() > 1) {
+            start = micros();
+            compose();
+            composeMicros += micros() - start;
+        }
+        xSemaphoreGive(mappingMutex);
         return true;
     }
+
+    void PhysicalLayer::loopSlices(Node *node) {
+        #if !CONFIG_FREERTOS_UNICORE
+            if (nrOfSlices > 1 && !sliceTaskHandle) {
+                xTaskCreatePinnedToCore(
+                    _sliceTask,                 // Function that should be called
+                    "MoonLight Slice",          // Name of the task (for debugging)
+                    4096,                       // Stack size (bytes)
+                    this,                       // Pass reference to this class instance
+                    (tskIDLE_PRIORITY + 2),     // task priority
+                    &sliceTaskHandle,           // Task handle
+                    1 - xPortGetCoreID()        // Pin to the other core then the render task
+                );
+                if (!sliceTaskHandle) {
+                    ESP_LOGW(TAG, "no slice task, render on one core");
+                    nrOfSlices = 1;
+                }
+            }
+            if (nrOfSlices > 1) {
+                sliceNode = node;
+                renderTaskHandle = xTaskGetCurrentTaskHandle();
+                xTaskNotifyGive(sliceTaskHandle); //slice 1 on the other core
+                node->loopSlice(0, 2);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY); //wait for slice 1, so the frame is complete
+                return;
+            }
+        #endif
+        node->loopSlice(0, 1);
+    }
+
+    void PhysicalLayer::_sliceTask(void *parameter) {
+        PhysicalLayer *layerP = (PhysicalLayer *)parameter;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY); //wait for loopSlices
+            layerP->sliceNode->loopSlice(1, 2);
+            xTaskNotifyGive(layerP->renderTaskHandle);
+        }
+    }
+
+    VirtualLayer *PhysicalLayer::getLayer(uint8_t layer) {
+        if (layer >= layerV.size()) {
+            while (layerV.size() <= layer) {
+                VirtualLayer *layerNew = new VirtualLayer();
+                layerNew->layerP = this;
+                layerV.push_back(layerNew);
+                ESP_LOGD(TAG, "layer %d added", layerV.size() - 1);
+            }
+            //map the new layers
+            remap();
+        }
+        return layerV[layer];
+    }
+
+    void PhysicalLayer::compose() {
+        size_t nrOfChannels = MIN(lights.header.nrOfLights * lights.header.channelsPerLight, lights.maxChannels);
+
+        memset(lights.channels, 0, nrOfChannels);
+
+        for (VirtualLayer * layer: layerV) {
+            if (!layer || !layer->layerChannels || layer->layerChannelsSize < nrOfChannels) continue; //not rendered yet
+            if (!layer->hasActiveEffect()) continue; //layers are not removed, a layer without effects would black out or dim the layers below
+            const byte *src = layer->layerChannels;
+            byte *dst = lights.channels;
+            const uint8_t opacity = layer->opacity;
+
+            switch (layer->blendMode) {
+                case bm_add:
+                    if (opacity == 255)
+                        for (size_t i = 0; i < nrOfChannels; i++) dst[i] = qadd8(dst[i], src[i]);
+                    else
+                        for (size_t i = 0; i < nrOfChannels; i++) dst[i] = qadd8(dst[i], scale8(src[i], opacity));
+                    break;
+                case bm_alpha: // crossfade the layers below with this layer
+                    if (opacity == 255)
+                        memcpy(dst, src, nrOfChannels);
+                    else
+                        for (size_t i = 0; i < nrOfChannels; i++) dst[i] = (src[i] * opacity + dst[i] * (255 - opacity) + 127) / 255;
+                    break;
+                case bm_max:
+                    for (size_t i = 0; i < nrOfChannels; i++) dst[i] = MAX(dst[i], scale8(src[i], opacity));
+                    break;
+                case bm_multiply: // darken the layers below, opacity 0 leaves them unchanged
+                    for (size_t i = 0; i < nrOfChannels; i++) dst[i] = dst[i] - scale8(dst[i] - scale8(dst[i], src[i]), opacity);
+                    break;
+                default: ;
+            }
+        }
+    }
     
+    void PhysicalLayer::copyToLightsOut() {
+        xSemaphoreTake(lightsOutMutex, portMAX_DELAY);
+        frameNr++;
+        if (lightsOut->maxChannels != lights.maxChannels) lightsOut->alloc(lights.maxChannels);
+
+        size_t nrOfChannels = MIN(lights.header.nrOfLights * lights.header.channelsPerLight, lightsOut->maxChannels);
+        size_t nrOfBlocks = (nrOfChannels + DIRTY_BLOCK_SIZE - 1) / DIRTY_BLOCK_SIZE;
+
+        //all blocks changed if not double buffered (nothing to compare with) or if the header changed (e.g. layout, brightness)
+        bool all = lightsOut == &lights || blockChanged.size() != nrOfBlocks
+                    || lightsOut->header.type != lights.header.type
+                    || lightsOut->header.nrOfLights != lights.header.nrOfLights
+                    || lightsOut->header.channelsPerLight != lights.header.channelsPerLight
+                    || lightsOut->header.brightness != lights.header.brightness;
+        blockChanged.resize(nrOfBlocks);
+        if (lightsOut != &lights) lightsOut->header = lights.header;
+
+        for (size_t block = 0; block < nrOfBlocks; block++) {
+            size_t start = block * DIRTY_BLOCK_SIZE;
+            size_t length = MIN(DIRTY_BLOCK_SIZE, nrOfChannels - start);
+            if (all || memcmp(&lightsOut->channels[start], &lights.channels[start], length) != 0) {
+                if (lightsOut != &lights) memcpy(&lightsOut->channels[start], &lights.channels[start], length);
+                blockChanged[block] = frameNr;
+            }
+        }
+        xSemaphoreGive(lightsOutMutex);
+    }
+
+    bool PhysicalLayer::changedSince(size_t start, size_t length, uint32_t frame) const {
+        size_t endBlock = MIN((start + length + DIRTY_BLOCK_SIZE - 1) / DIRTY_BLOCK_SIZE, blockChanged.size());
+        for (size_t block = start / DIRTY_BLOCK_SIZE; block < endBlock; block++) {
+            if (blockChanged[block] > frame) return true;
+        }
+        return false;
+    }
+
     void PhysicalLayer::addPin(uint8_t pinNr) {
         ESP_LOGD(TAG, "addPin %d", pinNr);
     }
 
     void PhysicalLayer::addLayoutPre() {
-        lights.header.nrOfLights = 0; // for pass1 and pass2 as in pass2 virtual layer needs it
         ESP_LOGD(TAG, "pass %d %d", pass, lights.header.nrOfLights);
 
         if (pass == 1) {
             lights.header.size = {0,0,0};
             lights.header.type = ct_count; //in progress...
-            delay(100); //wait to stop effects
+            layoutPositions.clear(); //keeps the capacity
             //dealloc pins
         } else {
             for (VirtualLayer * layer: layerV) {
-                //add the lights in the virtual layer
+                //add the lights in the virtual layer (uses nrOfLights of pass 1 to choose the mapping)
                 layer->addLayoutPre();
             }
         }
+        lights.header.nrOfLights = 0; // for pass1 and pass2 as in pass2 virtual layer needs it
+        passOpen = true;
     }
 
     void PhysicalLayer::addLight(Coord3D position) {
         
         if (pass == 1) {
             // ESP_LOGD(TAG, "%d,%d,%d", position.x, position.y, position.z);
-            if (lights.header.nrOfLights >= MAX_CHANNELS / sizeof(Coord3D)) {
-                //send the positions to the UI _socket_emit
-                //reset the index and continue...
-            } else
-                lights.positions[lights.header.nrOfLights] = {(uint16_t)position.x, (uint16_t)position.y, (uint16_t)position.z};
-
-                lights.header.size = lights.header.size.maximum(position);
+            lights.header.size = lights.header.size.maximum(position);
+            layoutPositions.push_back({(uint16_t)position.x, (uint16_t)position.y, (uint16_t)position.z}); //send to the monitor in chunks, see ModuleAnimations::monitorSendPositions
         } else {
             for (VirtualLayer * layer: layerV) {
                 //add the position in the virtual layer
@@ -89,65 +256,235 @@ PhysicalLayer::PhysicalLayer() {
     void PhysicalLayer::addLayoutPost() {
         if (pass == 1) {
             lights.header.size += Coord3D{1,1,1};
-            ESP_LOGD(TAG, "pass %d #:%d s:%d,%d,%d (%d=%d+%d)", pass, lights.header.nrOfLights, lights.header.size.x, lights.header.size.y, lights.header.size.z, sizeof(Lights), sizeof(LightsHeader), sizeof(lights.leds));
-            //send the positions to the UI _socket_emit
-            lights.header.type = ct_Position; //filled with positions, set back to ct_Leds in Animations
+            ESP_LOGD(TAG, "pass %d #:%d s:%d,%d,%d (%d bytes)", pass, lights.header.nrOfLights, lights.header.size.x, lights.header.size.y, lights.header.size.z, layoutPositions.size() * sizeof(Coord3D16));
+            layoutNr++; //send the positions to the monitor
+            //effects stay stopped (type) until pass 2
         } else {
             ESP_LOGD(TAG, "pass %d %d", pass, lights.header.nrOfLights);
+            //size the lights to the layout (lightsOut if not double buffered)
+            xSemaphoreTake(lightsOutMutex, portMAX_DELAY);
+            lights.alloc(lights.header.nrOfLights * lights.header.channelsPerLight);
+            xSemaphoreGive(lightsOutMutex);
             for (VirtualLayer * layer: layerV) {
                 //add the position in the virtual layer
                 layer->addLayoutPost();
             }
+            lights.header.type = ct_Leds; //effects can run again
             // initLightsToBlend();
         }
+        passOpen = false;
 
         //driver init // alloc pins
     }
 
+    void PhysicalLayer::mapPass(std::function<void()> map) {
+        xSemaphoreTake(mappingMutex, portMAX_DELAY); //effects and the monitor wait until the pass is done
+        map();
+        if (passOpen) { //e.g. a live script stopped with an error: close the pass with the lights added so far
+            ESP_LOGW(TAG, "pass %d not closed by the layout", pass);
+            addLayoutPost();
+        }
+        xSemaphoreGive(mappingMutex);
+    }
+
+    void PhysicalLayer::remap() {
+        if (mappingDeferred) return;
+        if (layoutPositions.empty() || layoutPositions.size() != lights.header.nrOfLights) { //no (complete) layout known: run the layouts
+            for (Node *node: nodes) {
+                if (node->hasLayout && node->on) {
+                    ESP_LOGD(TAG, "map %s", node->animation);
+                    for (pass = 1; pass <= 2; pass++)
+                        node->map();
+                }
+            }
+            return;
+        }
+
+        //only pass 2 (the modifiers): no pass 1 so effects continue and no delay
+        [[maybe_unused]] unsigned long start = micros(); //only used in the log
+        pass = 2;
+        mapPass([this]() {
+            addLayoutPre();
+            for (const Coord3D16 &position: layoutPositions) {
+                for (VirtualLayer * layer: layerV) {
+                    layer->addLight(position);
+                }
+                lights.header.nrOfLights++;
+            }
+            addLayoutPost();
+        });
+        ESP_LOGD(TAG, "remap %d lights %luus", lights.header.nrOfLights, micros() - start);
+    }
+
+    //mapping cache file: MappingCacheHeader, layoutPositions, then per virtual layer MappingCacheLayer, mapping table, indexes and offsets
+    struct MappingCacheHeader {
+        uint32_t version;
+        uint32_t key;
+        Coord3D size;
+        uint8_t nrOfLayers;
+    };
+
+    struct MappingCacheLayer {
+        Coord3D size;
+        uint16_t nrOfLights;
+        uint16_t nrOfRows;
+        uint8_t wideMapping;
+        uint8_t oneToOne;
+    };
+
+    template <typename T>
+    static void writeVector(File &file, const std::vector<T> &vector, size_t count) {
+        uint32_t size = count;
+        file.write((const uint8_t *)&size, sizeof(size));
+        file.write((const uint8_t *)vector.data(), count * sizeof(T));
+    }
+
+    template <typename T>
+    static bool readVector(File &file, std::vector<T> &vector) {
+        uint32_t size = 0;
+        if (file.read((uint8_t *)&size, sizeof(size)) != sizeof(size) || size * sizeof(T) > (size_t)file.available()) return false;
+        vector.resize(size);
+        return file.read((uint8_t *)vector.data(), size * sizeof(T)) == size * sizeof(T);
+    }
+
+    //true if the size is not 0 and contains all positions
+    static bool validPositions(const std::vector<Coord3D16> &positions, const Coord3D &size) {
+        if (size.x <= 0 || size.y <= 0 || size.z <= 0) return false;
+        for (const Coord3D16 &position: positions)
+            if (position.x >= size.x || position.y >= size.y || position.z >= size.z) return false;
+        return true;
+    }
+
+    //true if a mapping read from the cache file has a row per one to many light and only refers to existing rows and physical lights
+    template <typename M>
+    static bool validMapping(const std::vector<M> &table, const VirtualLayer *layer, const MappingCacheLayer &cacheLayer, size_t nrOfLightsP) {
+        const std::vector<uint16_t> &offsets = layer->mappingTableOffsets;
+        //a size of 0 divides by 0, more lights than the size indexes outside the buckets (see VirtualLayer::buildMappedLights)
+        const Coord3D &size = cacheLayer.size;
+        if (size.x <= 0 || size.y <= 0 || size.z <= 0 || cacheLayer.nrOfLights > (size_t)size.x * size.y * size.z) return false;
+        if (table.size() != cacheLayer.nrOfLights || offsets.size() != cacheLayer.nrOfRows + 1u || offsets.back() != layer->mappingTableIndexes.size()) return false;
+        for (size_t row = 0; row < cacheLayer.nrOfRows; row++)
+            if (offsets[row] > offsets[row + 1]) return false;
+        for (uint16_t indexP: layer->mappingTableIndexes)
+            if (indexP >= nrOfLightsP) return false;
+        for (const M &map: table) {
+            if (map.mapType == m_oneLight && map.indexP >= nrOfLightsP) return false;
+            if (map.mapType == m_moreLights && map.indexes >= cacheLayer.nrOfRows) return false;
+        }
+        return true;
+    }
+
+    bool PhysicalLayer::saveMapping(uint32_t key) {
+        if (layoutPositions.empty() || layoutPositions.size() != lights.header.nrOfLights) return false; //no (complete) layout
+
+        File file = ESPFS.open(MAPPING_CACHE_FILE, FILE_WRITE);
+        if (!file) {
+            ESP_LOGW(TAG, "cannot write %s", MAPPING_CACHE_FILE);
+            return false;
+        }
+
+        MappingCacheHeader cacheHeader = {MAPPING_CACHE_VERSION, key, lights.header.size, (uint8_t)layerV.size()};
+        file.write((const uint8_t *)&cacheHeader, sizeof(cacheHeader));
+        writeVector(file, layoutPositions, layoutPositions.size());
+        for (VirtualLayer * layer: layerV) {
+            MappingCacheLayer cacheLayer = {layer->size, layer->nrOfLights, layer->mappingTableIndexesSizeUsed, layer->wideMapping, layer->oneToOne};
+            file.write((const uint8_t *)&cacheLayer, sizeof(cacheLayer));
+            if (layer->wideMapping)
+                writeVector(file, layer->mappingTableWide, layer->mappingTableSizeUsed);
+            else
+                writeVector(file, layer->mappingTable, layer->mappingTableSizeUsed);
+            writeVector(file, layer->mappingTableIndexes, layer->mappingTableIndexes.size());
+            writeVector(file, layer->mappingTableOffsets, layer->mappingTableOffsets.size());
+        }
+        ESP_LOGD(TAG, "%s %d bytes key %08x", MAPPING_CACHE_FILE, file.size(), key);
+        file.close();
+        return true;
+    }
+
+    bool PhysicalLayer::loadMapping(uint32_t key) {
+        File file = ESPFS.open(MAPPING_CACHE_FILE);
+        if (!file) return false;
+
+        MappingCacheHeader cacheHeader;
+        if (file.read((uint8_t *)&cacheHeader, sizeof(cacheHeader)) != sizeof(cacheHeader) || cacheHeader.version != MAPPING_CACHE_VERSION
+                || cacheHeader.key != key || cacheHeader.nrOfLayers != layerV.size()) {
+            ESP_LOGD(TAG, "%s not for this layout", MAPPING_CACHE_FILE);
+            file.close();
+            return false;
+        }
+
+        [[maybe_unused]] unsigned long start = micros(); //only used in the log
+        xSemaphoreTake(mappingMutex, portMAX_DELAY); //no effects on a half loaded mapping
+
+        bool ok = readVector(file, layoutPositions) && layoutPositions.size() <= UINT16_MAX && validPositions(layoutPositions, cacheHeader.size);
+        for (VirtualLayer * layer: layerV) {
+            MappingCacheLayer cacheLayer;
+            ok = ok && file.read((uint8_t *)&cacheLayer, sizeof(cacheLayer)) == sizeof(cacheLayer);
+            if (!ok) break;
+
+            layer->resetMapping();
+            layer->wideMapping = cacheLayer.wideMapping;
+            //free the table not used
+            if (layer->wideMapping) {
+                std::vector<PhysMap>().swap(layer->mappingTable);
+                ok = readVector(file, layer->mappingTableWide);
+            } else {
+                std::vector<PhysMapWide>().swap(layer->mappingTableWide);
+                ok = readVector(file, layer->mappingTable);
+            }
+            ok = ok && readVector(file, layer->mappingTableIndexes) && readVector(file, layer->mappingTableOffsets);
+            //a truncated or stale file must not make setLight write outside the lights (layoutPositions: the physical lights)
+            ok = ok && (layer->wideMapping? validMapping(layer->mappingTableWide, layer, cacheLayer, layoutPositions.size()): validMapping(layer->mappingTable, layer, cacheLayer, layoutPositions.size()));
+            if (!ok) break;
+
+            layer->size = cacheLayer.size;
+            layer->nrOfLights = cacheLayer.nrOfLights;
+            layer->mappingTableSizeUsed = cacheLayer.nrOfLights;
+            layer->oneToOne = cacheLayer.oneToOne;
+            layer->mappingTableIndexesSizeUsed = cacheLayer.nrOfRows; //last, so setLight only uses complete rows
+            layer->buildMappedLights(); //not stored, as derived from the mapping table
+        }
+        ok = ok && file.available() == 0; //the file has the length of what is read
+        file.close();
+
+        if (ok) {
+            //as after pass 1 and pass 2
+            lights.header.size = cacheHeader.size;
+            lights.header.nrOfLights = layoutPositions.size();
+            xSemaphoreTake(lightsOutMutex, portMAX_DELAY);
+            ok = lights.alloc(lights.header.nrOfLights * lights.header.channelsPerLight);
+            xSemaphoreGive(lightsOutMutex);
+            if (ok) {
+                layoutNr++; //send the positions to the monitor
+                lights.header.type = ct_Leds;
+            }
+        }
+        if (!ok) { //corrupt file or no memory: map as usual
+            ESP_LOGW(TAG, "%s not loaded", MAPPING_CACHE_FILE);
+            for (VirtualLayer * layer: layerV) layer->resetMapping();
+            layoutPositions.clear();
+        }
+
+        xSemaphoreGive(mappingMutex);
+        if (ok) ESP_LOGD(TAG, "%s %d lights %d layers %luus", MAPPING_CACHE_FILE, lights.header.nrOfLights, layerV.size(), micros() - start);
+        return ok;
+    }
+
     // an effect is using a virtual layer: tell the effect in which layer to run...
 
 
     //run one loop of an effect
-    Node* PhysicalLayer::addNode(const char * animation, uint8_t index) {
+    Node* PhysicalLayer::addNode(const char * animation, uint8_t index, uint8_t layer) {
+
+        size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT); //internal and PSRAM
 
         Node *node = nullptr;
-        if (equal(animation, "Solid🔥")) {
-            node = new SolidEffect();
-        //alphabetically from here
-        } else if (equal(animation, "BouncingBalls🔥")) {
-            node = new BouncingBallsEffect();
-        } else if (equal(animation, "Lines🔥")) {
-            node = new LinesEffect();
-        } else if (equal(animation, "Lissajous🔥")) {
-            node = new LissajousEffect();
-        } else if (equal(animation, "MovingHead🔥")) {
-            node = new MovingHeadEffect();
-        } else if (equal(animation, "Rainbow🔥")) {
-            node = new RainbowEffect();
-        } else if (equal(animation, "Random🔥")) {
-            node = new RandomEffect();
-        } else if (equal(animation, "RipplesEffect🔥")) {
-            node = new RipplesEffect();
-        } else if (equal(animation, "RGBWPar🔥")) {
-            node = new RGBWParEffect();
-        } else if (equal(animation, "Sinelon🔥")) {
-            node = new SinelonEffect();
-        } else if (equal(animation, "Sinus🔥")) {
-            node = new SinusEffect();
-        } else if (equal(animation, "SphereMoveEffect🔥")) {
-            node = new SphereMoveEffect();
-        } else if (equal(animation, "DMX🚥")) {
-            node = new DMXLayout();
-        } else if (equal(animation, "Panel🚥")) {
-            node = new PanelLayout();
-        } else if (equal(animation, "Rings🚥")) {
-            node = new RingsLayout();
-        } else if (equal(animation, "Mirror💎")) {
-            node = new MirrorModifier();
-        } else if (equal(animation, "Multiply💎")) {
-            node = new MultiplyModifier();
-        } else if (equal(animation, "Pinwheel💎")) {
-            node = new PinwheelModifier();
+        const NodeType *nodeType = findNodeType(animation);
+        if (nodeType) {
+            node = nodeType->create();
+            //the kind tells what the node does to the mapping (live scripts: see LiveScriptNode::setup)
+            node->hasLayout = nodeType->kind == nk_layout;
+            node->hasModifier = nodeType->kind == nk_modifier;
         #if FT_LIVESCRIPT
             } else {
                 node = new LiveScriptNode();
@@ -155,25 +492,52 @@ PhysicalLayer::PhysicalLayer() {
         }
 
         if (node) {
-            node->constructor(layerV[0], animation); //pass the layer to the node
+            VirtualLayer *layerNode = getLayer(layer);
+            node->constructor(layerNode, animation); //pass the layer to the node
             node->setup(); //run the setup of the effect
-            // layerV[0]->nodes.reserve(index+1);
-            if (index >= layerV[0]->nodes.size())
-                layerV[0]->nodes.push_back(node);
+            node->heapSize = (int32_t)freeHeap - (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+            // nodes.reserve(index+1);
+            xSemaphoreTake(mappingMutex, portMAX_DELAY); //not while the effects run
+            if (index >= nodes.size())
+                nodes.push_back(node);
             else
-                layerV[0]->nodes[index] = node; //add the node to the layer
+                nodes[index] = node; //add the node to the layer
+            updateLayerNodes();
+            xSemaphoreGive(mappingMutex);
         }
 
-        ESP_LOGD(TAG, "%s (s:%d)", animation, layerV[0]->nodes.size());
+        ESP_LOGD(TAG, "%s (s:%d l:%d)", animation, nodes.size(), layer);
 
         return node;
     }
 
     void PhysicalLayer::removeNode(Node *node) {
-        ESP_LOGD(TAG, "remove node (s:%d)", layerV[0]->nodes.size());
+        ESP_LOGD(TAG, "remove node (s:%d)", nodes.size());
+        xSemaphoreTake(mappingMutex, portMAX_DELAY); //not while the effects run
+        updateLayerNodes(); //node is not in nodes anymore, remove it from its layer before deleting
+        xSemaphoreGive(mappingMutex);
         node->destructor();
         delete node;
-        // layerV[0]->nodes[index] = nullptr;
+        // nodes[index] = nullptr;
+    }
+
+    void PhysicalLayer::moveNode(Node *node, uint8_t layer) {
+        VirtualLayer *layerNode = getLayer(layer);
+        if (node->layerV == layerNode) return;
+        ESP_LOGD(TAG, "move %s to layer %d", node->animation, layer);
+        xSemaphoreTake(mappingMutex, portMAX_DELAY); //not while the effects run
+        node->layerV = layerNode;
+        updateLayerNodes();
+        xSemaphoreGive(mappingMutex);
+    }
+
+    void PhysicalLayer::updateLayerNodes() {
+        for (VirtualLayer * layer: layerV) {
+            layer->nodes.clear(); //keeps capacity
+        }
+        for (Node *node: nodes) {
+            node->layerV->nodes.push_back(node);
+        }
     }
 
     // // to be called in setup, if more then one effect
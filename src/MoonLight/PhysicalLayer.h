@@ -16,11 +16,14 @@
 #undef TAG
 #define TAG "💫"
 
-#define MAX_CHANNELS 8192*3 //physical leds
-#define NUM_LEDS MAX_CHANNELS / 3 //physical leds
+#define MAX_CHANNELS_INTERNAL 8192*3 //lights buffers up to this size in internal RAM, bigger in PSRAM if available
+#define DIRTY_BLOCK_SIZE 64 //channels, granularity of the change tracking of lightsOut
+#define MAPPING_CACHE_FILE "/config/mapping.bin" //layout positions and mapping tables of the last boot, see saveMapping
+#define MAPPING_CACHE_VERSION 2 //change if the format of the file or of PhysMap changes
 
 #include <Arduino.h>
 #include <vector>
+#include <functional>
 #include "FastLED.h"
 #include "../MoonBase/Utilities.h"
 
@@ -78,20 +81,29 @@ struct LightsHeader {
   uint16_t nrOfLights = 256;
   Coord3D size = {16,16,1}; //12 bytes not 0,0,0 to prevent div0 eg in Octopus2D
   uint8_t channelsPerLight = 3; //RGB default
-  uint8_t dummy2[3];
+  uint8_t delta = false; //monitor: data contains the changed blocks (uint16_t first block, uint16_t nr of blocks, channels) instead of all channels
+  uint16_t offset = 0; //monitor ct_Position: index of the first position in the data, see ModuleAnimations::monitorSendPositions
 }; // fill with dummies to make size 24, be aware of padding so do not change order of vars
 
 struct Lights {
   LightsHeader header;
-  union {
-    CRGB leds[NUM_LEDS];
-    CRGBW ledsRGBW[MAX_CHANNELS / sizeof(CRGBW)];
-    byte channels[MAX_CHANNELS];
-    MovingHead movingHeads[MAX_CHANNELS / sizeof(MovingHead)];
-    CrazyCurtain crazyCurtain[MAX_CHANNELS / sizeof(CrazyCurtain)]; // 6 bytes
-    Coord3D positions[MAX_CHANNELS / sizeof(Coord3D)]; //for layout / pass == 1, send positions to monitor / preview
+  union { //sized at runtime, see alloc
+    CRGB *leds = nullptr;
+    CRGBW *ledsRGBW;
+    byte *channels;
+    MovingHead *movingHeads;
+    CrazyCurtain *crazyCurtain; // 6 bytes
   };
+  size_t maxChannels = 0; //allocated size of channels
   // std::vector<size_t> universes; //tells at which byte the universe starts
+
+  //(re)allocates channels, contents is kept. Room for a copy of the header is reserved in front of channels, see headerAndChannels
+  bool alloc(size_t nrOfChannels);
+  //copy of the header followed by channels, to send in one go (e.g. monitor)
+  byte *headerAndChannels() {
+    memcpy(channels - sizeof(LightsHeader), &header, sizeof(LightsHeader));
+    return channels - sizeof(LightsHeader);
+  }
 };
 
 //contains the Lights structure/definition and implements layout functions (add*, modify*)
@@ -99,30 +111,79 @@ class PhysicalLayer {
 
     public:
 
-    Lights lights; //the physical lights
+    Lights lights; //the physical lights, effects render in here (back buffer)
+    Lights *lightsOut = &lights; //the physical lights as send to the drivers (front buffer), copied from lights at the end of each frame
+
+    //change tracking of lightsOut, so outputs can send only what changed since their last send
+    uint32_t frameNr = 0; //nr of frames copied to lightsOut
+    std::vector<uint32_t> blockChanged; //frameNr of the last change of each DIRTY_BLOCK_SIZE channels of lightsOut
+    SemaphoreHandle_t lightsOutMutex = nullptr; //taken while lightsOut and blockChanged are resized or written, so readers outside the render and output task (monitor) see whole frames
 
     // std::vector<bool> lightsToBlend; //this is a 1-bit vector !!! overlapping effects will blend
     // uint8_t globalBlend = 128; // to do add as UI control...
 
     std::vector<VirtualLayer *> layerV; // the virtual layers using this physical layer 
+    std::vector<Node *> nodes; // the nodes of all virtual layers, in the order of the UI
+
+    uint32_t effectsMicros = 0; //time spend in the effects of all frames, reset by the reader (see ModuleAnimations::loop1s)
+    uint32_t composeMicros = 0; //time spend in compose of all frames, idem
 
     PhysicalLayer();
 
     bool setup();
     bool loop();
 
+    //get a virtual layer, created if not existing yet
+    VirtualLayer *getLayer(uint8_t layer);
+    //if more then one virtual layer, blend the frame buffers of the virtual layers into lights
+    void compose();
+    //copy the changed blocks of lights into lightsOut and register them in blockChanged
+    void copyToLightsOut();
+    //true if channels start..start+length-1 of lightsOut changed after frame
+    bool changedSince(size_t start, size_t length, uint32_t frame) const;
+
+    //parallel rendering: effects with hasSlices render slice 0 in the render task and slice 1 in sliceTask on the other core
+    uint8_t nrOfSlices = 1; //1: render core only, 2: both cores
+    TaskHandle_t sliceTaskHandle = nullptr; //created when first needed
+    TaskHandle_t renderTaskHandle = nullptr; //notified by sliceTask when its slice is done
+    Node *sliceNode = nullptr; //the node sliceTask renders
+    //run loopSlice of a node over nrOfSlices, returns when all slices are done
+    void loopSlices(Node *node);
+    static void _sliceTask(void *parameter);
+
     
     uint8_t pass = 0; //'class global' so addLight/Pin functions know which pass it is in
+    std::vector<Coord3D16> layoutPositions; //positions of the last layout (pass 1), so remap can run pass 2 without the layout, and send to the monitor
+    uint32_t layoutNr = 0; //incremented if layoutPositions changed, so the monitor knows when to send them
+    SemaphoreHandle_t mappingMutex = nullptr; //taken by mapPass, node changes and by loop, so effects never run on a half build mapping or node list
+
+    //network input (see ModuleArtnetIn): the receiver writes lights instead of the effects and gives frameReceived when a frame is complete
+    bool receiving = false;
+    SemaphoreHandle_t frameReceived = nullptr;
     void addLayoutPre();
     void addPin(uint8_t pinNr);
     void addLight(Coord3D position);
     void addLayoutPost();
+    bool passOpen = false; //between addLayoutPre and addLayoutPost
+    //run one pass of a layout (map calls addLayoutPre, addLight and addLayoutPost) with mappingMutex taken
+    //the mutex is always released, addLayoutPost is called if map did not
+    void mapPass(std::function<void()> map);
+    //rerun the mapping (e.g. modifier changed): pass 2 on layoutPositions, the layout nodes are only rerun if no positions known
+    void remap();
+
+    bool mappingDeferred = false; //layouts and remap do not map (e.g. while the nodes are created at boot), see ModuleAnimations::begin
+    //store the layout positions and the mapping of all virtual layers in MAPPING_CACHE_FILE, key identifies the layout and modifiers
+    bool saveMapping(uint32_t key);
+    //restore the layout positions and mappings from MAPPING_CACHE_FILE if it is stored with the same key, instead of running pass 1 and 2
+    bool loadMapping(uint32_t key);
 
     // an effect is using a virtual layer: tell the effect in which layer to run...
 
     //run one loop of an effect
-    Node *addNode(const char * animation, uint8_t index);
+    Node *addNode(const char * animation, uint8_t index, uint8_t layer = 0);
     void removeNode(Node * node);
+    void moveNode(Node * node, uint8_t layer);
+    void updateLayerNodes(); //fill the nodes of each virtual layer from nodes, with mappingMutex taken (the effects iterate them)
 
     // to be called in setup, if more then one effect
     // void initLightsToBlend();
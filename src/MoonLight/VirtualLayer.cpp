@@ -36,13 +36,17 @@ VirtualLayer::~VirtualLayer() {
   }
   nodes.clear();
 
-  //clear array of array of indexes
-  for (std::vector<uint16_t> mappingTableIndex: mappingTableIndexes) {
-    mappingTableIndex.clear();
-  }
+  free(layerChannels);
+  layerChannels = nullptr;
+  layerChannelsSize = 0;
+
+  //clear the one to many mappings
   mappingTableIndexes.clear();
+  mappingTableOffsets.clear();
+  mappingTableIndexesBuild.clear();
   //clear mapping table
   mappingTable.clear();
+  mappingTableWide.clear();
 }
 
 void VirtualLayer::setup() {
@@ -52,30 +56,67 @@ void VirtualLayer::setup() {
 }
 
 void VirtualLayer::loop() {
+  //own frame buffer if more then one layer, layers are not removed: free the buffer of a layer without effects, compose skips it
+  size_t size = layerP->layerV.size() > 1? layerP->lights.header.nrOfLights * layerP->lights.header.channelsPerLight: 0;
+  bool active = size == 0 || hasActiveEffect();
+  if (!active) size = 0;
+  if (size != layerChannelsSize) {
+    free(layerChannels);
+    layerChannels = size?(byte *)calloc(size, 1):nullptr;
+    layerChannelsSize = layerChannels?size:0;
+    ESP_LOGD(TAG, "layer buffer %d", layerChannelsSize);
+  }
+  if (!active) return; //modifiers without effects: nothing to render
+
   fadeToBlackMin();
 
   for (Node *node: nodes) {
-    if (node->on)
+    if (node->on) {
+      uint32_t start = ESP.getCycleCount();
       node->loop();
+      if (node->hasSlices) layerP->loopSlices(node);
+      node->loopTiming.add(ESP.getCycleCount() - start);
+    }
   }
 };
 
+bool VirtualLayer::hasActiveEffect() const {
+  for (const Node *node: nodes)
+    if (node->on && !node->hasLayout && !node->hasModifier) return true;
+  return false;
+}
+
 void VirtualLayer::resetMapping() {
 
-  for (std::vector<uint16_t> mappingTableIndex: mappingTableIndexes) {
-    mappingTableIndex.clear();
-  }
-  mappingTableIndexesSizeUsed = 0; //do not clear mappingTableIndexes, reuse it
+  mappingTableIndexesSizeUsed = 0; //first, so setLight stops using the rows
+  oneToOne = false;
+  mappingTableIndexes.clear(); //clear keeps the capacity, so it is reused
+  mappingTableOffsets.clear();
+  mappingTableIndexesBuild.clear();
+  mappedLights.clear();
+  bucketOffsets.clear();
+  distances.clear(); //rebuild for the new size when asked
+  angles.clear();
+  normalized.clear();
 
   for (size_t i = 0; i < mappingTable.size(); i++) { //this cannot be removed ...
     mappingTable[i] = PhysMap();
   }
+  for (size_t i = 0; i < mappingTableWide.size(); i++) {
+    mappingTableWide[i] = PhysMapWide();
+  }
   mappingTableSizeUsed = 0;
 
 }
 
-void VirtualLayer::addIndexP(PhysMap &physMap, uint16_t indexP) {
-  // ESP_LOGD(TAG, "i:%d t:%d s:%d i:%d", indexP, physMap.mapType, mappingTableIndexes.size(), physMap.indexes);
+void VirtualLayer::addIndexP(uint16_t indexV, uint16_t indexP) {
+  if (wideMapping) addIndexP(mappingTableWide, indexV, indexP); else addIndexP(mappingTable, indexV, indexP);
+}
+
+template <typename M>
+void VirtualLayer::addIndexP(std::vector<M> &table, uint16_t indexV, uint16_t indexP) {
+  M &physMap = table[indexV];
+  // ESP_LOGD(TAG, "i:%d t:%d s:%d i:%d", indexP, physMap.mapType, mappingTableIndexesBuild.size(), physMap.indexes);
   switch (physMap.mapType) {
     case m_color:
     // case m_rgbColor:
@@ -84,20 +125,16 @@ void VirtualLayer::addIndexP(PhysMap &physMap, uint16_t indexP) {
       break;
     case m_oneLight: {
       uint16_t oldIndexP = physMap.indexP;
-      // change to m_moreLights and add the old indexP and new indexP to the multiple indexP array
-      mappingTableIndexesSizeUsed++; //add a new slot in the mappingTableIndexes
-      if (mappingTableIndexes.size() < mappingTableIndexesSizeUsed)
-        mappingTableIndexes.push_back({oldIndexP, indexP});
-      else
-        mappingTableIndexes[mappingTableIndexesSizeUsed-1] = {oldIndexP, indexP};
-
-        physMap.indexes = mappingTableIndexesSizeUsed - 1; //array position
-        physMap.mapType = m_moreLights;
+      // change to m_moreLights and collect the old indexP and new indexP, rows are made in addLayoutPost
+      mappingTableIndexesBuild.push_back({indexV, oldIndexP});
+      mappingTableIndexesBuild.push_back({indexV, indexP});
+      physMap.indexes = 2; //count the physical lights until addLayoutPost
+      physMap.mapType = m_moreLights;
       break; }
     case m_moreLights:
-      // mappingTableIndexes.reserve(physMap.indexes+1);
-      mappingTableIndexes[physMap.indexes].push_back(indexP);
-      // ESP_LOGD(TAG, " more %d", mappingTableIndexes.size());
+      mappingTableIndexesBuild.push_back({indexV, indexP});
+      physMap.indexes++;
+      // ESP_LOGD(TAG, " more %d", mappingTableIndexesBuild.size());
       break;
   }
   // ESP_LOGD(TAG, "\n");
@@ -113,74 +150,31 @@ uint16_t VirtualLayer::XYZ(Coord3D &position) {
   return XYZUnprojected(position);
 }
 
-void VirtualLayer::setLightColor(const uint16_t indexV, const CRGB& color) {
-  // Serial.printf(" %d: %d,%d,%d", indexV, color.r, color.g, color.b);
-  if (indexV < mappingTableSizeUsed) {
-    // ESP_LOGD(TAG, "setLightColor %d %d %d %d", indexV, color.r, color.g, color.b, mappingTableSizeUsed);
-    switch (mappingTable[indexV].mapType) {
-      case m_color:{
-        mappingTable[indexV].rgb14 = ((min(color.r + 3, 255) >> 3) << 9) + 
-                                     ((min(color.g + 3, 255) >> 3) << 4) + 
-                                      (min(color.b + 7, 255) >> 4);
-        break;
-      }
-      case m_oneLight: {
-        uint16_t indexP = mappingTable[indexV].indexP;
-        //temp fix for cube202020 (some curtains are bgr)
-        // if (indexP > 2800) {
-        //   fix->ledsP[indexP].r = color.b;
-        //   fix->ledsP[indexP].g = color.g;
-        //   fix->ledsP[indexP].b = color.r;
-        // }
-        // else
-        // layerP->lights.leds[indexP] = layerP->lightsToBlend[indexP]?blend(color, layerP->lights.leds[indexP], layerP->globalBlend):color;
-        layerP->lights.leds[indexP] = color;
-        break; }
-      case m_moreLights:
-        if (mappingTable[indexV].indexes < mappingTableIndexes.size())
-          for (uint16_t indexP: mappingTableIndexes[mappingTable[indexV].indexes]) {
-            // if (indexP > 2800) {
-            //   fix->ledsP[indexP].r = color.b;
-            //   fix->ledsP[indexP].g = color.g;
-            //   fix->ledsP[indexP].b = color.r;
-            // } else
-            // layerP->lights.leds[indexP] = layerP->lightsToBlend[indexP]?blend(color, layerP->lights.leds[indexP], layerP->globalBlend): color;
-            layerP->lights.leds[indexP] = color;
-          }
-        else
-          ESP_LOGW(TAG, "dev setLightColor i:%d m:%d s:%d", indexV, mappingTable[indexV].indexes, mappingTableIndexes.size());
-        break;
-      default: ;
-    }
-  }
-  else if (indexV < NUM_LEDS) {//no mapping
-    // layerP->lights.leds[indexV] = layerP->lightsToBlend[indexV]?blend(color, layerP->lights.leds[indexV], layerP->globalBlend): color;
-    layerP->lights.leds[indexV] = color;
-    // layerP->lights.dmxChannels[indexV] = (byte*)&color;
-  }
-  // some operations will go out of bounds e.g. VUMeter, uncomment below lines if you wanna test on a specific effect
-  // else //if (indexV != UINT16_MAX) //assuming UINT16_MAX is set explicitly (e.g. in XYZ)
-  //   ESP_LOGW(TAG, " dev sLC %d >= %d", indexV, STARLIGHT_NUM_LEDS);
+CRGB VirtualLayer::getLightColor(const uint16_t indexV) const {
+  return wideMapping? getLightColor(mappingTableWide, indexV): getLightColor(mappingTable, indexV);
 }
 
-CRGB VirtualLayer::getLightColor(const uint16_t indexV) const {
+template <typename M>
+CRGB VirtualLayer::getLightColor(const std::vector<M> &table, const uint16_t indexV) const {
   if (indexV < mappingTableSizeUsed) {
-    switch (mappingTable[indexV].mapType) {
+    switch (table[indexV].mapType) {
       case m_oneLight:
-        return layerP->lights.leds[mappingTable[indexV].indexP]; 
+        return leds()[table[indexV].indexP]; 
         break;
       case m_moreLights:
-        return layerP->lights.leds[mappingTableIndexes[mappingTable[indexV].indexes][0]]; //any will do as they are all the same
+        if (table[indexV].indexes < mappingTableIndexesSizeUsed)
+          return leds()[mappingTableIndexes[mappingTableOffsets[table[indexV].indexes]]]; //any will do as they are all the same
+        return CRGB::Black;
         break;
       default: // m_color:
-        return CRGB((mappingTable[indexV].rgb14 >> 9) << 3, 
-                    (mappingTable[indexV].rgb14 >> 4) << 3, 
-                     mappingTable[indexV].rgb14       << 4);
+        return CRGB((table[indexV].rgb14 >> 9) << 3, 
+                    (table[indexV].rgb14 >> 4) << 3, 
+                     table[indexV].rgb14       << 4);
         break;
     }
   }
-  else if (indexV < NUM_LEDS) //no mapping
-    return layerP->lights.leds[indexV];
+  else if ((indexV + 1) * sizeof(CRGB) <= channelsSize()) //no mapping
+    return leds()[indexV];
   else {
     // some operations will go out of bounds e.g. VUMeter, uncomment below lines if you wanna test on a specific effect
     // ESP_LOGD(TAG, " dev gPC %d >= %d", indexV, STARLIGHT_MAXLEDS);
@@ -189,8 +183,7 @@ CRGB VirtualLayer::getLightColor(const uint16_t indexV) const {
 }
 
 // void VirtualLayer::setLightsToBlend() {
-//   for (const std::vector<uint16_t>& mappingTableIndex: mappingTableIndexes) {
-//       for (const uint16_t indexP: mappingTableIndex)
+//   for (const uint16_t indexP: mappingTableIndexes) {
 //       layerP->lightsToBlend[indexP] = true;
 //     }
 //     for (const PhysMap &physMap: mappingTable) {
@@ -216,15 +209,8 @@ void VirtualLayer::fadeToBlackMin() {
     //     }
     //   }
     // } else 
-    if (layerP->layerV.size() == 1) { //faster, else manual 
-      fastled_fadeToBlackBy(layerP->lights.leds, layerP->lights.header.nrOfLights, fadeBy);
-    } else {
-      for (uint16_t index = 0; index < nrOfLights; index++) {
-        CRGB color = getLightColor(index);
-        color.nscale8(255-fadeBy);
-        setLightColor(index, color);
-      }
-    }
+    //each layer has its own frame buffer with all physical lights (see channels())
+    fastled_fadeToBlackBy(leds(), layerP->lights.header.nrOfLights, fadeBy);
     //reset fade
     fadeMin = 0; //no fade
   }
@@ -238,12 +224,7 @@ void VirtualLayer::fill_solid(const CRGB& color) {
   //     }
   //   }
   // } else 
-  if (layerP->layerV.size() == 1) { //faster, else manual 
-    fastled_fill_solid(layerP->lights.leds, layerP->lights.header.nrOfLights, color);
-  } else {
-    for (uint16_t index = 0; index < nrOfLights; index++)
-      setLightColor(index, color);
-  }
+  fastled_fill_solid(leds(), layerP->lights.header.nrOfLights, color);
 }
 
 void VirtualLayer::fill_rainbow(const uint8_t initialhue, const uint8_t deltahue) {
@@ -259,23 +240,60 @@ void VirtualLayer::fill_rainbow(const uint8_t initialhue, const uint8_t deltahue
   //     }
   //   }
   // } else 
-  if (layerP->layerV.size() == 1) { //faster, else manual 
-    fastled_fill_rainbow(layerP->lights.leds, layerP->lights.header.nrOfLights, initialhue, deltahue);
-  } else {
-    CHSV hsv;
-    hsv.hue = initialhue;
-    hsv.val = 255;
-    hsv.sat = 240;
-
-    for (uint16_t index = 0; index < nrOfLights; index++) {
-      setLightColor(index, hsv);
-      hsv.hue += deltahue;
-    }
+  fastled_fill_rainbow(leds(), layerP->lights.header.nrOfLights, initialhue, deltahue);
+}
+
+const uint16_t *VirtualLayer::distanceField() {
+  size_t nrOfVirtual = (size_t)size.x * size.y * size.z;
+  if (distances.size() != nrOfVirtual) {
+    distances.resize(nrOfVirtual);
+    Coord3D position;
+    for (position.z = 0; position.z < size.z; position.z++)
+      for (position.y = 0; position.y < size.y; position.y++)
+        for (position.x = 0; position.x < size.x; position.x++) {
+          float d = distance(position.x, position.y, position.z, size.x / 2.0f, size.y / 2.0f, size.z / 2.0f) * FIELD_DISTANCE_SCALE;
+          distances[XYZUnprojected(position)] = MIN(d + 0.5f, UINT16_MAX);
+        }
+    ESP_LOGD(TAG, "distance field %d x %d x %d", size.x, size.y, size.z);
+  }
+  return distances.data();
+}
+
+const uint8_t *VirtualLayer::angleField() {
+  size_t nrOfVirtual = (size_t)size.x * size.y * size.z;
+  if (angles.size() != nrOfVirtual) {
+    angles.resize(nrOfVirtual);
+    Coord3D position;
+    for (position.z = 0; position.z < size.z; position.z++)
+      for (position.y = 0; position.y < size.y; position.y++)
+        for (position.x = 0; position.x < size.x; position.x++)
+          angles[XYZUnprojected(position)] = (int)roundf(atan2f(position.y - size.y / 2.0f, position.x - size.x / 2.0f) * 128 / PI) & 255;
+    ESP_LOGD(TAG, "angle field %d x %d x %d", size.x, size.y, size.z);
   }
+  return angles.data();
+}
+
+void VirtualLayer::buildNormalized() {
+  if (normalized.size() == (size_t)(size.x + size.y + size.z)) return;
+  normalized.resize(size.x + size.y + size.z);
+  uint8_t *n = normalized.data();
+  for (int x = 0; x < size.x; x++) *n++ = size.x > 1? x * 255 / (size.x - 1): 0;
+  for (int y = 0; y < size.y; y++) *n++ = size.y > 1? y * 255 / (size.y - 1): 0;
+  for (int z = 0; z < size.z; z++) *n++ = size.z > 1? z * 255 / (size.z - 1): 0;
 }
 
 void VirtualLayer::addLayoutPre() {
 
+  //compact mapping if the physical lights fit in 14 bits, wide mapping otherwise (nrOfLights of pass 1)
+  bool wide = layerP->lights.header.nrOfLights > PHYSMAP_MAX_LIGHTS;
+  if (wide != wideMapping) {
+    mappingTableSizeUsed = 0; //first, so setLight stops using the old table
+    wideMapping = wide;
+    //free the table not used
+    if (wideMapping) std::vector<PhysMap>().swap(mappingTable); else std::vector<PhysMapWide>().swap(mappingTableWide);
+    ESP_LOGD(TAG, "%s mapping for %d lights", wideMapping?"wide":"compact", layerP->lights.header.nrOfLights);
+  }
+
   resetMapping();
 
   nrOfLights = 0;
@@ -283,8 +301,10 @@ void VirtualLayer::addLayoutPre() {
 
   //modifiers
   for (Node *node: nodes) {
-    if (node->hasModifier && node->on)
+    if (node->hasModifier && node->on) {
+      node->modifyTiming.reset();
       node->modifyLayout();
+    }
   }
 }
 
@@ -292,26 +312,73 @@ void VirtualLayer::addLight(Coord3D position) {
 
   //modifiers
   for (Node *node: nodes) {
-    if (node->hasModifier && node->on)
+    if (node->hasModifier && node->on) {
+      uint32_t start = ESP.getCycleCount();
       node->modifyLight(position);
+      node->modifyTiming.add(ESP.getCycleCount() - start);
+    }
   }
 
   uint16_t indexV = XYZUnprojected(position);
   if (indexV >= nrOfLights) {
-    mappingTable.resize(indexV + 1); //make sure the index fits
+    if (wideMapping) mappingTableWide.resize(indexV + 1); else mappingTable.resize(indexV + 1); //make sure the index fits
     nrOfLights = indexV + 1;
     mappingTableSizeUsed = nrOfLights;
   }
-  addIndexP(mappingTable[indexV], layerP->lights.header.nrOfLights);
+  addIndexP(indexV, layerP->lights.header.nrOfLights);
 }
 
 void VirtualLayer::addLayoutPost() {
+  if (wideMapping) addLayoutPost(mappingTableWide); else addLayoutPost(mappingTable);
+}
+
+template <typename M>
+void VirtualLayer::addLayoutPost(std::vector<M> &table) {
+  unsigned long start = micros();
+
+  // make the rows of the one to many mappings: PhysMap.indexes contains the nr of physical lights, replace by row nr
+  mappingTableOffsets.reserve(mappingTableIndexesBuild.size() / 2 + 1); //at least 2 physical lights per row
+  uint16_t nrOfPhysicalM = 0;
+  for (size_t indexV = 0; indexV < nrOfLights; indexV++) {
+    M &map = table[indexV];
+    if (map.mapType == m_moreLights) {
+      mappingTableOffsets.push_back(nrOfPhysicalM); //start of the row
+      nrOfPhysicalM += map.indexes;
+      map.indexes = mappingTableOffsets.size() - 1; //row nr
+    }
+  }
+  uint16_t nrOfRows = mappingTableOffsets.size();
+  mappingTableOffsets.push_back(nrOfPhysicalM); //end of the last row
+
+  // fill the rows, mappingTableOffsets[row] is used as insert position and moves to the start of the next row
+  mappingTableIndexes.resize(nrOfPhysicalM);
+  for (const std::pair<uint16_t, uint16_t> &indexVP: mappingTableIndexesBuild) {
+    mappingTableIndexes[mappingTableOffsets[table[indexVP.first].indexes]++] = indexVP.second;
+  }
+  // shift back so mappingTableOffsets[row] is the start of the row again
+  for (uint16_t row = nrOfRows; row > 0; row--) {
+    mappingTableOffsets[row] = mappingTableOffsets[row - 1];
+  }
+  mappingTableOffsets[0] = 0;
+
+  std::vector<std::pair<uint16_t, uint16_t>>().swap(mappingTableIndexesBuild); //free the build memory
+  mappingTableIndexesSizeUsed = nrOfRows; //last, so setLight only uses complete rows
+
+  //no modifiers and lights added in index order (e.g. a non serpentine panel): writers can skip the mapping table
+  bool isOneToOne = nrOfLights == layerP->lights.header.nrOfLights;
+  for (size_t indexV = 0; isOneToOne && indexV < nrOfLights; indexV++)
+    isOneToOne = table[indexV].mapType == m_oneLight && table[indexV].indexP == indexV;
+  oneToOne = isOneToOne;
+
+  buildMappedLights(table);
+
+  [[maybe_unused]] unsigned long buildTime = micros() - start; //only used in the log
+
   // prepare logging:
   uint16_t nrOfPhysical = 0;
-  uint16_t nrOfPhysicalM = 0;
   uint16_t nrOfColor = 0;
   for (size_t i = 0; i< nrOfLights; i++) {
-    PhysMap &map = mappingTable[i];
+    M &map = table[i];
     switch (map.mapType) {
       case m_color:
         nrOfColor++;
@@ -322,10 +389,8 @@ void VirtualLayer::addLayoutPost() {
         break;
       case m_moreLights:
         // Char<32> str;
-        for (uint16_t indexP: mappingTableIndexes[map.indexes]) {
-          // str += indexP;
-          nrOfPhysicalM++;
-        }
+        // for (uint16_t index = mappingTableOffsets[map.indexes]; index < mappingTableOffsets[map.indexes+1]; index++)
+        //   str += mappingTableIndexes[index];
         // ESP_LOGD(TAG, "%d mapping >1: #ledsP : %s", i, str.c_str());
         break;
     }
@@ -333,8 +398,54 @@ void VirtualLayer::addLayoutPost() {
     //   ESP_LOGD(TAG, "%d no mapping\n", x);
   }
 
-  ESP_LOGD(TAG, "V:%d x %d x %d = v:%d = 0:%d + 1:%d + m:%d (p:%d)", size.x, size.y, size.z, nrOfLights, nrOfColor, nrOfPhysical, mappingTableIndexesSizeUsed, nrOfPhysicalM);
+  ESP_LOGD(TAG, "V:%d x %d x %d = v:%d = 0:%d + 1:%d + m:%d (p:%d) mem:%d+%d build:%luus%s", size.x, size.y, size.z, nrOfLights, nrOfColor, nrOfPhysical, mappingTableIndexesSizeUsed, nrOfPhysicalM, table.size() * sizeof(M), (mappingTableIndexes.size() + mappingTableOffsets.size()) * sizeof(uint16_t), buildTime, oneToOne?" 1:1":"");
+
+}
+
+void VirtualLayer::buildMappedLights() {
+  if (wideMapping) buildMappedLights(mappingTableWide); else buildMappedLights(mappingTable);
+}
+
+template <typename M>
+void VirtualLayer::buildMappedLights(const std::vector<M> &table) {
+  mappedLights.clear(); //clear keeps the capacity, so it is reused
+  bucketOffsets.clear();
+
+  uint16_t nrOfMapped = 0;
+  for (size_t indexV = 0; indexV < mappingTableSizeUsed; indexV++)
+    if (table[indexV].mapType != m_color) nrOfMapped++;
+
+  size_t nrOfVirtual = (size_t)size.x * size.y * size.z;
+  if (nrOfMapped == 0 || nrOfMapped * SPARSE_FILL >= nrOfVirtual) { //dense: looping over the layer is as fast, free the memory
+    std::vector<MappedLight>().swap(mappedLights);
+    std::vector<uint16_t>().swap(bucketOffsets);
+    return;
+  }
+
+  nrOfBuckets = {(size.x + BUCKET_SIZE - 1) / BUCKET_SIZE, (size.y + BUCKET_SIZE - 1) / BUCKET_SIZE, (size.z + BUCKET_SIZE - 1) / BUCKET_SIZE};
+  size_t nrOfB = nrOfBuckets.x * nrOfBuckets.y * nrOfBuckets.z;
+  bucketOffsets.assign(nrOfB + 1, 0);
+  mappedLights.resize(nrOfMapped);
+
+  // count the lights per bucket in bucketOffsets[b + 1], then add up so bucketOffsets[b] is the start of bucket b
+  for (size_t indexV = 0; indexV < mappingTableSizeUsed; indexV++) {
+    if (table[indexV].mapType == m_color) continue;
+    Coord3D position = {(int)(indexV % size.x), (int)(indexV / size.x % size.y), (int)(indexV / (size.x * size.y))};
+    bucketOffsets[position.x / BUCKET_SIZE + position.y / BUCKET_SIZE * nrOfBuckets.x + position.z / BUCKET_SIZE * nrOfBuckets.x * nrOfBuckets.y + 1]++;
+  }
+  for (size_t b = 0; b < nrOfB; b++) bucketOffsets[b + 1] += bucketOffsets[b];
+
+  // fill the buckets, bucketOffsets[b] is used as insert position and moves to the start of the next bucket
+  for (size_t indexV = 0; indexV < mappingTableSizeUsed; indexV++) {
+    if (table[indexV].mapType == m_color) continue;
+    Coord3D16 position = {(uint16_t)(indexV % size.x), (uint16_t)(indexV / size.x % size.y), (uint16_t)(indexV / (size.x * size.y))};
+    mappedLights[bucketOffsets[position.x / BUCKET_SIZE + position.y / BUCKET_SIZE * nrOfBuckets.x + position.z / BUCKET_SIZE * nrOfBuckets.x * nrOfBuckets.y]++] = {(uint16_t)indexV, position};
+  }
+  // shift back so bucketOffsets[b] is the start of bucket b again
+  for (size_t b = nrOfB; b > 0; b--) bucketOffsets[b] = bucketOffsets[b - 1];
+  bucketOffsets[0] = 0;
 
+  ESP_LOGD(TAG, "sparse: %d of %d lights mapped, %d buckets, mem:%d", nrOfMapped, nrOfVirtual, nrOfB, mappedLights.size() * sizeof(MappedLight) + bucketOffsets.size() * sizeof(uint16_t));
 }
 
 #endif //FT_MOONLIGHT
\ No newline at end of file
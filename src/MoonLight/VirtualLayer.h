@@ -18,6 +18,7 @@
 #include <FastLED.h>
 
 #include "PhysicalLayer.h"
+#include "MoonMath.h"
 
 enum mapType {
     m_color,
@@ -26,6 +27,14 @@ enum mapType {
     m_count //keep as last entry
   };
   
+enum BlendMode {
+    bm_add,
+    bm_alpha,
+    bm_max,
+    bm_multiply,
+    bm_count //keep as last entry
+  };
+
 struct PhysMap {
     union {
       struct {                 //condensed rgb
@@ -33,7 +42,7 @@ struct PhysMap {
         byte mapType:2;        //2 bits (4)
       }; //16 bits
       uint16_t indexP: 14;   //16384 one physical light (type==1) index to ledsP array
-      uint16_t indexes:14;  //16384 multiple physical lights (type==2) index in std::vector<std::vector<uint16_t>> mappingTableIndexes;
+      uint16_t indexes:14;  //16384 multiple physical lights (type==2) row in mappingTableOffsets (during pass 2: nr of physical lights)
     }; // 2 bytes  
     
     PhysMap() {
@@ -43,6 +52,133 @@ struct PhysMap {
     }
   };
 
+//used instead of PhysMap if there are more physical lights than fit in 14 bits (see VirtualLayer::addLayoutPre)
+struct PhysMapWide {
+    union {
+      uint16_t rgb14;        //condensed rgb (554 RGB)
+      uint16_t indexP;       //65536 one physical light (type==1) index to ledsP array
+      uint16_t indexes;      //65536 multiple physical lights (type==2) row in mappingTableOffsets (during pass 2: nr of physical lights)
+    }; // 2 bytes
+    byte mapType;
+    
+    PhysMapWide() {
+      mapType = m_color; // the default until indexP is added
+      rgb14 = 0;
+    }
+  }; // 4 bytes (aligned)
+
+#define PHYSMAP_MAX_LIGHTS 16384 //max nr of physical lights for PhysMap (14 bits)
+
+#define SPARSE_FILL 2 //a layout is sparse if less than 1 in SPARSE_FILL virtual lights is mapped, see VirtualLayer::mappedLights
+#define BUCKET_SIZE 8 //virtual lights per dimension of a bucket of mappedLights
+
+#define FIELD_DISTANCE_SCALE 16 //unit of distanceField: 1/16 light
+
+//virtual light which is mapped to physical lights, with its position in the virtual layer
+struct MappedLight {
+  uint16_t indexV;
+  Coord3D16 position;
+}; // 8 bytes
+
+//writes lights of one type to a virtual layer, the frame buffer, mapping table and size of T are resolved when created (VirtualLayer::writer)
+//only valid during one loop, as a remap or layer change can move the buffers
+template <typename T>
+struct LightWriter {
+  T *lights; //frame buffer of the layer
+  PhysMap *table; //compact mapping or nullptr
+  PhysMapWide *tableWide; //wide mapping or nullptr
+  uint16_t tableSize; //0 if no mapping or a 1:1 mapping
+  const uint16_t *indexes; //rows of the one to many mappings
+  const uint16_t *offsets;
+  uint16_t nrOfRows;
+  uint16_t nrOfLights; //if no mapping: lights in the frame buffer
+  Coord3D size; //of the virtual layer
+
+  void set(const Coord3D &position, const T &value) const {set(position.x + position.y*size.x + position.z * size.x * size.y, value);}
+  void set(const uint16_t indexV, const T &value) const {
+    if (indexV < tableSize) {
+      if (tableWide) setMapped(tableWide[indexV], value); else setMapped(table[indexV], value);
+    }
+    else if (indexV < nrOfLights) //no mapping
+      lights[indexV] = value;
+    // some operations will go out of bounds e.g. VUMeter, uncomment below lines if you wanna test on a specific effect
+    // else //if (indexV != UINT16_MAX) //assuming UINT16_MAX is set explicitly (e.g. in XYZ)
+    //   ESP_LOGW(TAG, " dev sLC %d >= %d", indexV, STARLIGHT_NUM_LEDS);
+  }
+
+  //batch writes, the mapping is resolved once per call, spans without (or with 1:1) mapping are copied at once
+  //values[i] is written to light indexV + i * stride
+  void setSpan(const uint16_t indexV, const T *values, const uint16_t count, const uint16_t stride = 1) const {
+    size_t index = indexV;
+    if (tableSize == 0 && stride == 1) {
+      if (index < nrOfLights) memcpy(&lights[index], values, MIN(count, nrOfLights - index) * sizeof(T));
+    } else if (tableWide) setSpanMapped(tableWide, index, values, count, stride);
+    else setSpanMapped(table, index, values, count, stride);
+  }
+  void setRow(const uint16_t y, const uint16_t z, const T *values) const {setSpan(y*size.x + z * size.x * size.y, values, size.x);} //size.x values
+  void setColumn(const uint16_t x, const uint16_t z, const T *values) const {setSpan(x + z * size.x * size.y, values, size.y, size.x);} //size.y values
+  void setPlane(const uint16_t z, const T *values) const {setSpan(z * size.x * size.y, values, size.x * size.y);} //size.x * size.y values
+
+  //value is written to count lights from indexV, stride apart
+  void fill(const uint16_t indexV, const T &value, const uint16_t count, const uint16_t stride = 1) const {
+    size_t index = indexV;
+    if (tableSize == 0 && stride == 1) {
+      if (index >= nrOfLights) return;
+      size_t end = MIN(index + count, (size_t)nrOfLights);
+      const byte *valueAsBytes = reinterpret_cast<const byte*>(&value);
+      bool sameBytes = true; //e.g. black or white: memset
+      for (size_t i = 1; i < sizeof(T); i++) sameBytes = sameBytes && valueAsBytes[i] == valueAsBytes[0];
+      if (sameBytes)
+        memset(&lights[index], valueAsBytes[0], (end - index) * sizeof(T));
+      else
+        for (; index < end; index++) lights[index] = value;
+    } else
+      for (size_t i = 0; i < count; i++, index += stride)
+        set(index, value);
+  }
+
+  template <typename M>
+  void setSpanMapped(M *table, size_t index, const T *values, const uint16_t count, const uint16_t stride) const {
+    for (size_t i = 0; i < count; i++, index += stride) {
+      if (index < tableSize) setMapped(table[index], values[i]);
+      else if (index < nrOfLights) lights[index] = values[i]; //no mapping
+    }
+  }
+
+  template <typename M>
+  void setMapped(M &map, const T &value) const {
+    switch (map.mapType) {
+      case m_oneLight:
+        lights[map.indexP] = value;
+        break;
+      case m_moreLights:
+        if (map.indexes < nrOfRows) {
+          const uint16_t *indexPEnd = indexes + offsets[map.indexes + 1];
+          for (const uint16_t *indexP = indexes + offsets[map.indexes]; indexP < indexPEnd; indexP++)
+            lights[*indexP] = value;
+        }
+        break;
+      default: // m_color: only room for storing colors
+        setColor(map, value);
+    }
+  }
+
+  template <typename M>
+  static void setColor(M &map, const CRGB &color) {
+    map.rgb14 = ((min(color.r + 3, 255) >> 3) << 9) + 
+                ((min(color.g + 3, 255) >> 3) << 4) + 
+                 (min(color.b + 7, 255) >> 4);
+  }
+  template <typename M, typename V>
+  static void setColor(M &map, const V &value) {} //no room for other types
+};
+
+//one writer per ChannelType
+typedef LightWriter<CRGB> LedsWriter; //ct_Leds
+typedef LightWriter<CRGBW> LedsRGBWWriter; //ct_LedsRGBW
+typedef LightWriter<MovingHead> MovingHeadWriter; //ct_MovingHead
+typedef LightWriter<CrazyCurtain> CrazyCurtainWriter; //ct_CrazyCurtain
+
 class VirtualLayer {
 
   public:
@@ -52,16 +188,46 @@ class VirtualLayer {
     Coord3D middle = {8,8,1}; //not 0,0,0 to prevent div0 eg in Octopus2D
 
     //they will be reused to avoid fragmentation
-    std::vector<PhysMap> mappingTable;
-    std::vector<std::vector<uint16_t>> mappingTableIndexes;
+    std::vector<PhysMap> mappingTable; //if the physical lights fit in PhysMap (PHYSMAP_MAX_LIGHTS)
+    std::vector<PhysMapWide> mappingTableWide; //otherwise, only one of both is in use
+    bool wideMapping = false;
+    bool oneToOne = false; //each virtual light is mapped to the physical light with the same index, no need to use the mapping table
+    //one to many mappings in compressed sparse row format: row r (PhysMap.indexes) has physical lights mappingTableIndexes[mappingTableOffsets[r] .. mappingTableOffsets[r+1]-1]
+    std::vector<uint16_t> mappingTableIndexes;
+    std::vector<uint16_t> mappingTableOffsets;
+    std::vector<std::pair<uint16_t, uint16_t>> mappingTableIndexesBuild; //indexV, indexP pairs of one to many mappings collected in pass 2, turned into rows in addLayoutPost
     uint16_t mappingTableSizeUsed = 0; 
-    uint16_t mappingTableIndexesSizeUsed = 0; 
+    uint16_t mappingTableIndexesSizeUsed = 0; //nr of rows
+
+    //sparse layouts (e.g. rings, sculptures): the mapped virtual lights sorted by bucket of BUCKET_SIZE^3, build in addLayoutPost, empty if dense
+    std::vector<MappedLight> mappedLights;
+    std::vector<uint16_t> bucketOffsets; //bucket b has mappedLights[bucketOffsets[b] .. bucketOffsets[b+1]-1]
+    Coord3D nrOfBuckets = {0,0,0};
+
+    //per virtual light fields for radial effects, build when first asked (in loop, not in loopSlice), cleared by resetMapping
+    std::vector<uint16_t> distances; //see distanceField
+    std::vector<uint8_t> angles; //see angleField
+    std::vector<uint8_t> normalized; //see normalizedX/Y/Z
 
     PhysicalLayer *layerP; //physical leds the virtual leds are mapped to
     std::vector<Node *> nodes;
   
     uint8_t fadeMin;
 
+    //if more then one layer, each layer renders in its own frame buffer, blended into the physical lights by PhysicalLayer::compose
+    byte *layerChannels = nullptr;
+    size_t layerChannelsSize = 0;
+    uint8_t blendMode = bm_add;
+    uint8_t opacity = 255;
+
+    //false if no effect of the layer is on: with more then one layer, nothing is rendered or composed and the frame buffer is freed (see loop)
+    bool hasActiveEffect() const;
+
+    //the frame buffer effects write to
+    byte *channels() const {return layerChannels?layerChannels:layerP->lights.channels;}
+    CRGB *leds() const {return (CRGB *)channels();}
+    size_t channelsSize() const {return layerChannels?layerChannelsSize:layerP->lights.maxChannels;}
+
     VirtualLayer() {
       ESP_LOGD(TAG, "constructor");
     }
@@ -72,7 +238,9 @@ class VirtualLayer {
     void loop();
 
     void resetMapping();
-    void addIndexP(PhysMap &physMap, uint16_t indexP);
+    void addIndexP(uint16_t indexV, uint16_t indexP);
+    template <typename M>
+    void addIndexP(std::vector<M> &table, uint16_t indexV, uint16_t indexP);
 
     uint16_t XYZ(Coord3D &position);
     
@@ -81,76 +249,64 @@ class VirtualLayer {
     }
 
     void setLightColor(const Coord3D &position, const CRGB& color) {setLightColor(XYZUnprojected(position), color);}
-    void setLightColor(const uint16_t indexV, const CRGB& color); //uses leds
+    void setLightColor(const uint16_t indexV, const CRGB& color) {writer<CRGB>().set(indexV, color);} //uses leds
     CRGB getLightColor(const uint16_t indexV) const;
+    template <typename M>
+    CRGB getLightColor(const std::vector<M> &table, const uint16_t indexV) const;
     void fadeToBlackBy(const uint8_t fadeBy);
     void fadeToBlackMin();
 
+    //frame writer for lights of type T (CRGB, CRGBW, MovingHead, CrazyCurtain, see LedsWriter etc.)
+    //get it once per loop and call set for each light
+    template <typename T>
+    LightWriter<T> writer() {
+      LightWriter<T> writer;
+      writer.lights = (T *)channels();
+      writer.table = wideMapping?nullptr:mappingTable.data();
+      writer.tableWide = wideMapping?mappingTableWide.data():nullptr;
+      writer.tableSize = oneToOne?0:mappingTableSizeUsed;
+      writer.indexes = mappingTableIndexes.data();
+      writer.offsets = mappingTableOffsets.data();
+      writer.nrOfRows = mappingTableIndexesSizeUsed;
+      writer.nrOfLights = MIN(channelsSize() / sizeof(T), UINT16_MAX);
+      writer.size = size;
+      return writer;
+    }
+
     template <typename T>
     void setLight(const Coord3D &position, const T& value) {setLight(XYZUnprojected(position), value);}
     template <typename T>
-    void setLight(const uint16_t indexV, const T& value) {  // Serial.printf(" %d: %d,%d,%d", indexV, color.r, color.g, color.b);
-      if (indexV < mappingTableSizeUsed) {
-        // ESP_LOGD(TAG, "setLightColor %d %d %d %d", indexV, color.r, color.g, color.b, mappingTableSizeUsed);
-        switch (mappingTable[indexV].mapType) {
-          case m_color:{
-            //only room for storing colors
-            if (std::is_same<T, CRGB>::value) {
-              const byte* valueAsBytes = reinterpret_cast<const byte*>(&value);
-              mappingTable[indexV].rgb14 = ((min(valueAsBytes[0] + 3, 255) >> 3) << 9) + 
-                                         ((min(valueAsBytes[1] + 3, 255) >> 3) << 4) + 
-                                          (min(valueAsBytes[2] + 7, 255) >> 4);
-            }
-            break;
-          }
-          case m_oneLight: {
-            uint16_t indexP = mappingTable[indexV].indexP;
-            //temp fix for cube202020 (some curtains are bgr)
-            // if (indexP > 2800) {
-            //   fix->ledsP[indexP].r = color.b;
-            //   fix->ledsP[indexP].g = color.g;
-            //   fix->ledsP[indexP].b = color.r;
-            // }
-            // else
-            memcpy(&layerP->lights.channels[indexP*sizeof(T)], &value, sizeof(T));
-      
-            // &layerP->lights.channels[indexP*sizeof(T)] = valueAsBytes;
-            break; }
-          case m_moreLights:
-            if (mappingTable[indexV].indexes < mappingTableIndexes.size())
-              for (uint16_t indexP: mappingTableIndexes[mappingTable[indexV].indexes]) {
-                // if (indexP > 2800) {
-                //   fix->ledsP[indexP].r = color.b;
-                //   fix->ledsP[indexP].g = color.g;
-                //   fix->ledsP[indexP].b = color.r;
-                // } else
-                memcpy(&layerP->lights.channels[indexP*sizeof(T)], &value, sizeof(T));
-              }
-            else
-              ESP_LOGW(TAG, "dev setLightColor i:%d m:%d s:%d", indexV, mappingTable[indexV].indexes, mappingTableIndexes.size());
-            break;
-          default: ;
-        }
-      }
-      else if (indexV < NUM_LEDS) {//no mapping
-        memcpy(&layerP->lights.channels[indexV*sizeof(T)], &value, sizeof(T));
-      }
-        // layerP->lights.dmxChannels[indexV] = (byte*)&color;
-      // some operations will go out of bounds e.g. VUMeter, uncomment below lines if you wanna test on a specific effect
-      // else //if (indexV != UINT16_MAX) //assuming UINT16_MAX is set explicitly (e.g. in XYZ)
-      //   ESP_LOGW(TAG, " dev sLC %d >= %d", indexV, STARLIGHT_NUM_LEDS);
+    void setLight(const uint16_t indexV, const T& value) {
+      writer<T>().set(indexV, value);
     }
 
+    //batch versions of setLight, see LightWriter
+    template <typename T>
+    void setSpan(const uint16_t indexV, const T *values, const uint16_t count, const uint16_t stride = 1) {writer<T>().setSpan(indexV, values, count, stride);}
+    template <typename T>
+    void setRow(const uint16_t y, const uint16_t z, const T *values) {writer<T>().setRow(y, z, values);}
+    template <typename T>
+    void setColumn(const uint16_t x, const uint16_t z, const T *values) {writer<T>().setColumn(x, z, values);}
+    template <typename T>
+    void setPlane(const uint16_t z, const T *values) {writer<T>().setPlane(z, values);}
+    template <typename T>
+    void fillStrided(const uint16_t indexV, const T &value, const uint16_t count, const uint16_t stride = 1) {writer<T>().fill(indexV, value, count, stride);}
 
     template <typename T>
     T getLight(const uint16_t indexV) const {
+      return wideMapping? getLight<PhysMapWide, T>(mappingTableWide, indexV): getLight<PhysMap, T>(mappingTable, indexV);
+    }
+    template <typename M, typename T>
+    T getLight(const std::vector<M> &table, const uint16_t indexV) const {
       if (indexV < mappingTableSizeUsed) {
-        switch (mappingTable[indexV].mapType) {
+        switch (table[indexV].mapType) {
           case m_oneLight:
-            return layerP->lights.channels[mappingTable[indexV].indexP * sizeof(T)]; 
+            return ((T *)channels())[table[indexV].indexP]; 
             break;
           case m_moreLights:
-            return layerP->lights.channels[mappingTableIndexes[mappingTable[indexV].indexes][0] * sizeof(T)]; //any will do as they are all the same
+            if (table[indexV].indexes < mappingTableIndexesSizeUsed)
+              return ((T *)channels())[mappingTableIndexes[mappingTableOffsets[table[indexV].indexes]]]; //any will do as they are all the same
+            return T();
             break;
           default: // m_color:
             return T();
@@ -166,8 +322,8 @@ class VirtualLayer {
             break;
         }
       }
-      else if (indexV < NUM_LEDS) //no mapping
-        return layerP->lights.channels[indexV * sizeof(T)];
+      else if ((indexV + 1) * sizeof(T) <= channelsSize()) //no mapping
+        return ((T *)channels())[indexV];
       else {
         // some operations will go out of bounds e.g. VUMeter, uncomment below lines if you wanna test on a specific effect
         // ESP_LOGD(TAG, " dev gPC %d >= %d", indexV, STARLIGHT_MAXLEDS);
@@ -178,6 +334,68 @@ class VirtualLayer {
     //to be called in loop, if more then one effect
     // void setLightsToBlend(); //uses leds
 
+    //calls f(indexV, position) for each mapped virtual light (sparse) or for each virtual light (dense), slice: see Node::loopSlice
+    template <typename F>
+    void forEachLight(F f, uint8_t slice = 0, uint8_t nrOfSlices = 1) const {
+      if (!mappedLights.empty()) {
+        size_t end = mappedLights.size() * (slice + 1) / nrOfSlices;
+        for (size_t i = mappedLights.size() * slice / nrOfSlices; i < end; i++)
+          f(mappedLights[i].indexV, (Coord3D)mappedLights[i].position);
+      } else {
+        Coord3D position;
+        for (position.z = 0; position.z < size.z; position.z++)
+          for (position.y = 0; position.y < size.y; position.y++)
+            for (position.x = size.x * slice / nrOfSlices; position.x < size.x * (slice + 1) / nrOfSlices; position.x++)
+              f(XYZUnprojected(position), position);
+      }
+    }
+
+    //calls f(indexV, distanceSquared) for the lights of forEachLight with rMin < distance to center < rMax (no sqrt)
+    //only the lights in the box around rMax are checked, sparse: only the mapped lights in the buckets overlapping that box
+    template <typename F>
+    void forEachLightInShell(const Coord3D &center, float rMin, float rMax, F f, uint8_t slice = 0, uint8_t nrOfSlices = 1) const {
+      Coord3D first = {MAX((int)floorf(center.x - rMax), 0), MAX((int)floorf(center.y - rMax), 0), MAX((int)floorf(center.z - rMax), 0)};
+      Coord3D last = {MIN((int)ceilf(center.x + rMax), size.x - 1), MIN((int)ceilf(center.y + rMax), size.y - 1), MIN((int)ceilf(center.z + rMax), size.z - 1)};
+      if (first.x > last.x || first.y > last.y || first.z > last.z) return; //outside the layer
+      const float rMin2 = rMin * rMin;
+      const float rMax2 = rMax * rMax;
+
+      if (!mappedLights.empty()) {
+        Coord3D bucket;
+        size_t nr = 0; //buckets are divided over the slices
+        for (bucket.z = first.z / BUCKET_SIZE; bucket.z <= last.z / BUCKET_SIZE; bucket.z++)
+          for (bucket.y = first.y / BUCKET_SIZE; bucket.y <= last.y / BUCKET_SIZE; bucket.y++)
+            for (bucket.x = first.x / BUCKET_SIZE; bucket.x <= last.x / BUCKET_SIZE; bucket.x++) {
+              if (nr++ % nrOfSlices != slice) continue;
+              size_t b = bucket.x + bucket.y * nrOfBuckets.x + bucket.z * nrOfBuckets.x * nrOfBuckets.y;
+              for (size_t i = bucketOffsets[b]; i < bucketOffsets[b + 1]; i++) {
+                const Coord3D16 &position = mappedLights[i].position;
+                uint32_t d2 = distanceSquared(position.x - center.x, position.y - center.y, position.z - center.z);
+                if (d2 > rMin2 && d2 < rMax2) f(mappedLights[i].indexV, d2);
+              }
+            }
+      } else {
+        Coord3D position;
+        int width = last.x + 1 - first.x;
+        for (position.z = first.z; position.z <= last.z; position.z++)
+          for (position.y = first.y; position.y <= last.y; position.y++)
+            for (position.x = first.x + width * slice / nrOfSlices; position.x < first.x + width * (slice + 1) / nrOfSlices; position.x++) {
+              uint32_t d2 = distanceSquared(position.x - center.x, position.y - center.y, position.z - center.z);
+              if (d2 > rMin2 && d2 < rMax2) f(XYZUnprojected(position), d2);
+            }
+      }
+    }
+
+    //distance of each virtual light (indexV) to the center of the layer (size / 2) * FIELD_DISTANCE_SCALE
+    const uint16_t *distanceField();
+    //polar angle of each virtual light (indexV) around the center of the layer in the x,y plane, 0..255 is 0..360 degrees, 0 is the x axis
+    const uint8_t *angleField();
+    //x, y or z scaled to 0..255 (0: first, 255: last light)
+    const uint8_t *normalizedX() {buildNormalized(); return normalized.data();}
+    const uint8_t *normalizedY() {buildNormalized(); return normalized.data() + size.x;}
+    const uint8_t *normalizedZ() {buildNormalized(); return normalized.data() + size.x + size.y;}
+    void buildNormalized();
+
     void fill_solid(const CRGB& color);
     void fill_rainbow(const uint8_t initialhue, const uint8_t deltahue);
 
@@ -186,6 +404,13 @@ class VirtualLayer {
     void addLight(Coord3D position);
 
     void addLayoutPost();
+    template <typename M>
+    void addLayoutPost(std::vector<M> &table);
+
+    //(re)build mappedLights, or free it if the layout is dense (e.g. after loading the mapping)
+    void buildMappedLights();
+    template <typename M>
+    void buildMappedLights(const std::vector<M> &table);
 
 };
 
@@ -27,6 +27,7 @@
     #if FT_ENABLED(FT_MOONLIGHT)
         #include "MoonLight/ModuleAnimations.h"
         #include "MoonLight/ModuleArtnet.h"
+        #include "MoonLight/ModuleArtnetIn.h"
     #endif
 #endif
 
@@ -62,6 +63,7 @@ LightStateService lightStateService = LightStateService(&server,
     #if FT_ENABLED(FT_MOONLIGHT)
         ModuleAnimations moduleAnimations = ModuleAnimations(&server, &esp32sveltekit, &filesService);
         ModuleArtnet moduleArtnet = ModuleArtnet(&server, &esp32sveltekit, &filesService);
+        ModuleArtnetIn moduleArtnetIn = ModuleArtnetIn(&server, &esp32sveltekit, &filesService);
     #endif
 #endif
     
@@ -84,6 +86,12 @@ void setup()
         #if FT_ENABLED(FT_MOONLIGHT)
             moduleAnimations.begin();
             moduleArtnet.begin();
+            moduleArtnetIn.begin();
+
+            //Art-Net is send by the output task of moduleAnimations, on the other core then the effects, after each frame (max Art-Net fps)
+            moduleAnimations.addOutputFunction([]() {
+                moduleArtnet.sendFrame();
+            });
         #endif
     #endif
 
@@ -120,20 +128,7 @@ void loop()
     // 🌙
     #if FT_ENABLED(FT_MOONBASE)
 
-        // 💫
-        #if FT_ENABLED(FT_MOONLIGHT)
-            moduleAnimations.loop();
-        #endif
-
-        //20ms loop
-        static int lastTime20ms = 0;
-        if (millis() - lastTime20ms > 20)
-        {
-            lastTime20ms = millis();
-            #if FT_ENABLED(FT_MOONLIGHT)
-                moduleArtnet.loop20ms();
-            #endif
-        }
+        // 💫 effects run in the render task of moduleAnimations (frame paced), see ModuleAnimations::_render
 
         //50ms loop
         static int lastTime50ms = 0;
@@ -152,6 +147,7 @@ void loop()
                 moduleInstances.loop1s();
                 #if FT_ENABLED(FT_MOONLIGHT)
                     moduleAnimations.loop1s();
+                    moduleArtnetIn.loop1s();
                 #endif
                 moduleDemo.loop1s();
 
@@ -0,0 +1,37 @@
+/**
+    @title     MoonLight
+    @file      bench.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//timing for the host benchmarks (bench_*.cpp): numbers on x86, compare them with each other, not with the ESP32
+
+#pragma once
+
+#include <chrono>
+
+//fastest of runs calls of function in microseconds: the least disturbed by other processes, prepare runs before each call and is not timed
+template <typename F, typename P>
+double bestMicros(int runs, F function, P prepare) {
+  double best = 1e30;
+  for (int run = 0; run < runs; run++) {
+    prepare();
+    auto start = std::chrono::steady_clock::now();
+    function();
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (micros < best) best = micros;
+  }
+  return best;
+}
+
+template <typename F>
+double bestMicros(int runs, F function) {return bestMicros(runs, function, []() {});}
+
+//keep a result the compiler could otherwise remove
+template <typename T>
+inline void keep(const T &value) {asm volatile("" : : "g"(&value) : "memory");}
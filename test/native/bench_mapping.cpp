@@ -0,0 +1,130 @@
+/**
+    @title     MoonLight
+    @file      bench_mapping.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//mapping, loop and output time of a 128x64 panel mirrored in x and y (8192 physical, 2048 virtual lights, 4 physical lights per virtual light)
+//the one to many rows in compressed sparse row format (mappingTableOffsets / mappingTableIndexes) are compared with
+//a vector of vectors (one heap block per virtual light), the format before the rows
+//
+//  make -C test/native bench
+
+#include "MoonLight/Nodes.h"
+#include "bench.h"
+
+PhysicalLayer layerP;
+
+const uint16_t width = 128, height = 64;
+const int runs = 200;
+
+//a width x height panel, lights row by row
+class BenchPanelLayout: public LayoutNode {
+public:
+  void addLayout() override {
+    for (int y = 0; y < height; y++)
+      for (int x = 0; x < width; x++)
+        layerV->layerP->addLight({x, y, 0});
+  }
+};
+
+//as Mirror💎 with mirrorX and mirrorY
+class BenchMirrorModifier: public Node {
+public:
+  Coord3D originalSize;
+  void modifyLayout() override {
+    layerV->size.x = (layerV->size.x + 1) / 2;
+    layerV->size.y = (layerV->size.y + 1) / 2;
+    originalSize = layerV->size;
+  }
+  void modifyLight(Coord3D &position) override {
+    if (position.x >= originalSize.x) position.x = originalSize.x * 2 - 1 - position.x;
+    if (position.y >= originalSize.y) position.y = originalSize.y * 2 - 1 - position.y;
+  }
+};
+
+template <class T>
+static T *addBenchNode(bool layout, bool modifier) {
+  T *node = new T();
+  node->constructor(layerP.layerV[0], "Bench");
+  node->hasLayout = layout;
+  node->hasModifier = modifier;
+  node->on = true;
+  layerP.nodes.push_back(node);
+  layerP.updateLayerNodes();
+  return node;
+}
+
+int main() {
+  addBenchNode<BenchPanelLayout>(true, false);
+  addBenchNode<BenchMirrorModifier>(false, true);
+  layerP.remap(); //runs the layout, the next remaps only pass 2
+  VirtualLayer *layer = layerP.layerV[0];
+  printf("%dx%d panel mirrored: %d physical, %d virtual lights, %d rows\n", width, height, layerP.lights.header.nrOfLights, layer->nrOfLights, layer->mappingTableIndexesSizeUsed);
+
+  //build: pass 2 of all lights through the modifier, then the rows
+  double remapMicros = bestMicros(runs, []() {layerP.remap();});
+
+  //the same mapping as vector of vectors, built from the (indexV, indexP) pairs in the order of pass 2 (physical lights)
+  std::vector<std::pair<uint16_t, uint16_t>> pairs;
+  for (uint16_t row = 0; row < layer->mappingTableIndexesSizeUsed; row++)
+    for (uint16_t i = layer->mappingTableOffsets[row]; i < layer->mappingTableOffsets[row + 1]; i++)
+      pairs.push_back({row, layer->mappingTableIndexes[i]});
+  std::sort(pairs.begin(), pairs.end(), [](const auto &a, const auto &b) {return a.second < b.second;});
+  std::vector<std::vector<uint16_t>> vectors;
+  double vectorsBuildMicros = bestMicros(runs, [&]() {
+    vectors.clear();
+    vectors.resize(layer->mappingTableIndexesSizeUsed);
+    for (const auto &pair: pairs) vectors[pair.first].push_back(pair.second);
+    keep(vectors);
+  }, [&]() {vectors = {};}); //free the rows, as a new mapping
+  //the rows only: what addLayoutPost builds from the pairs
+  std::vector<uint16_t> offsets, indexes;
+  double rowsBuildMicros = bestMicros(runs, [&]() {
+    offsets.assign(layer->mappingTableIndexesSizeUsed + 1, 0);
+    for (const auto &pair: pairs) offsets[pair.first + 1]++;
+    for (size_t row = 0; row < layer->mappingTableIndexesSizeUsed; row++) offsets[row + 1] += offsets[row];
+    indexes.resize(pairs.size());
+    std::vector<uint16_t> next(offsets.begin(), offsets.end() - 1);
+    for (const auto &pair: pairs) indexes[next[pair.first]++] = pair.second;
+    keep(indexes);
+  });
+
+  //frame write: each virtual light once
+  CRGB *leds = layerP.lights.leds;
+  double setLightMicros = bestMicros(runs, [&]() {
+    for (uint16_t indexV = 0; indexV < layer->nrOfLights; indexV++) layer->setLightColor(indexV, CRGB(indexV, indexV >> 8, 7));
+    keep(leds[0]);
+  });
+  //the rows and the vectors written the same way, without what setLightColor does for all mappings (table lookup, one to one, wide)
+  double rowsWriteMicros = bestMicros(runs, [&]() {
+    for (uint16_t indexV = 0; indexV < layer->nrOfLights; indexV++)
+      for (uint16_t i = offsets[indexV]; i < offsets[indexV + 1]; i++) leds[indexes[i]] = CRGB(indexV, indexV >> 8, 7);
+    keep(leds[0]);
+  });
+  double vectorsWriteMicros = bestMicros(runs, [&]() {
+    for (uint16_t indexV = 0; indexV < layer->nrOfLights; indexV++)
+      for (uint16_t indexP: vectors[indexV]) leds[indexP] = CRGB(indexV, indexV >> 8, 7);
+    keep(leds[0]);
+  });
+
+  printf("build: remap (pass 2) %.1fus, rows from pairs %.1fus, vector of vectors from pairs %.1fus\n", remapMicros, rowsBuildMicros, vectorsBuildMicros);
+  printf("frame write: setLightColor %.1fus, rows %.1fus, vector of vectors %.1fus\n", setLightMicros, rowsWriteMicros, vectorsWriteMicros);
+  printf("indexes memory: rows %dB in 2 blocks, vector of vectors %dB in %d blocks\n",
+    (int)((layer->mappingTableOffsets.size() + layer->mappingTableIndexes.size()) * sizeof(uint16_t)), (int)(pairs.size() * sizeof(uint16_t) + vectors.size() * sizeof(std::vector<uint16_t>)), (int)vectors.size());
+
+  //loop: an effect on all virtual lights, compose; output: the frame copied to the front buffer (all blocks changed)
+  Node *effect = layerP.addNode("Rainbow🔥", layerP.nodes.size());
+  effect->on = true;
+  double loopMicros = bestMicros(runs, []() {layerP.loop();});
+  layerP.lightsOut = new Lights(); //double buffered as in ModuleAnimations::begin
+  uint8_t value = 0;
+  double outputMicros = bestMicros(runs, []() {layerP.copyToLightsOut();}, [&]() {memset(layerP.lights.channels, ++value, layerP.lights.header.nrOfLights * 3);});
+  printf("loop (Rainbow) %.1fus, output (copyToLightsOut) %.1fus\n", loopMicros, outputMicros);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/**
+    @title     MoonLight
+    @file      bench_math.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//per light math of the effects: MoonMath tables and integer math against float math, time per call and max error
+//the hue table (hueTable) is not compared: stubs/FastLED.h has no HSV to RGB conversion
+//
+//  make -C test/native bench
+
+#include "MoonLight/MoonMath.h"
+#include "bench.h"
+
+#include <cmath>
+
+const int runs = 50;
+const int calls = 65536;
+
+//FastLED sin8_C: the sin8 the Lissajous effect used (stubs/FastLED.h returns 0)
+static uint8_t sin8Reference(uint8_t theta) {
+  static const uint8_t interleave[] = {0, 49, 49, 41, 90, 27, 117, 10};
+  uint8_t offset = theta;
+  if (theta & 0x40) offset = 255 - offset;
+  offset &= 0x3F;
+  uint8_t secoffset = offset & 0x0F;
+  if (theta & 0x40) secoffset++;
+  uint8_t section = offset >> 4;
+  uint8_t b = interleave[section * 2];
+  uint8_t m16 = interleave[section * 2 + 1];
+  uint8_t mx = (m16 * secoffset) >> 4;
+  int8_t y = mx + b;
+  if (theta & 0x80) y = -y;
+  return y + 128;
+}
+
+int main() {
+  //sine: all angles
+  int sinError = 0;
+  for (int angle = 0; angle < 65536; angle++)
+    sinError = MAX(sinError, abs(sinQ15(angle) - (int)lroundf(sinf(angle / ANGLE_PER_RADIAN) * 32767)));
+  double sinQ15Micros = bestMicros(runs, []() {
+    int32_t sum = 0;
+    for (int angle = 0; angle < calls; angle++) sum += sinQ15(angle);
+    keep(sum);
+  });
+  double sinfMicros = bestMicros(runs, []() {
+    float sum = 0;
+    for (int angle = 0; angle < calls; angle++) sum += sinf(angle / ANGLE_PER_RADIAN);
+    keep(sum);
+  });
+  printf("sinQ15 %.2fns, sinf %.2fns, max error %d of 32767\n", sinQ15Micros * 1000 / calls, sinfMicros * 1000 / calls, sinError);
+
+  //atan2: a 256 x 256 grid around the center
+  int atanError = 0;
+  for (int y = -128; y < 128; y++) {
+    for (int x = -128; x < 128; x++) {
+      if (!x && !y) continue;
+      int expected = (int)lroundf(atan2f(y, x) * ANGLE_PER_RADIAN) & 0xFFFF;
+      int error = abs((int16_t)(atan2Angle(y, x) - expected));
+      atanError = MAX(atanError, error);
+    }
+  }
+  double atan2AngleMicros = bestMicros(runs, []() {
+    uint32_t sum = 0;
+    for (int i = 0; i < calls; i++) sum += atan2Angle((i >> 8) - 128, (i & 0xFF) - 128);
+    keep(sum);
+  });
+  double atan2fMicros = bestMicros(runs, []() {
+    float sum = 0;
+    for (int i = 0; i < calls; i++) sum += atan2f((i >> 8) - 128, (i & 0xFF) - 128);
+    keep(sum);
+  });
+  printf("atan2Angle %.2fns, atan2f %.2fns, max error %d of 65536\n", atan2AngleMicros * 1000 / calls, atan2fMicros * 1000 / calls, atanError);
+
+  //square root: exact on each square, one below and one above, and all values below 2^20
+  size_t sqrtValues = 0, sqrtWrong = 0;
+  for (uint32_t root = 1; root < 65536; root++) {
+    uint32_t square = root * root;
+    sqrtWrong += (sqrt32(square) != root) + (sqrt32(square - 1) != root - 1) + (sqrt32(square + 1) != root);
+    sqrtValues += 3;
+  }
+  for (uint32_t value = 0; value < (1 << 20); value++, sqrtValues++) sqrtWrong += sqrt32(value) != (uint32_t)sqrt((double)value);
+  double sqrt32Micros = bestMicros(runs, []() {
+    uint32_t sum = 0;
+    for (int i = 0; i < calls; i++) sum += sqrt32(i * 977);
+    keep(sum);
+  });
+  double sqrtfMicros = bestMicros(runs, []() {
+    uint32_t sum = 0;
+    for (int i = 0; i < calls; i++) sum += (uint32_t)sqrtf(i * 977);
+    keep(sum);
+  });
+  printf("sqrt32 %.2fns, sqrtf %.2fns, %d of %d values wrong\n", sqrt32Micros * 1000 / calls, sqrtfMicros * 1000 / calls, (int)sqrtWrong, (int)sqrtValues);
+
+  //Lissajous: position from sinQ15 / cosQ15 against sin8 / cos8 and map, all 8 bit angles and sizes 2..128 (size 1: now 0, was 1)
+  int lissajousError = 0;
+  for (int size = 2; size <= 128; size++) {
+    for (int angle = 0; angle < 256; angle++) {
+      int expected = (map(2 * sin8Reference(angle), 0, 511, 0, 2 * (size - 1)) + 1) / 2;
+      int position = ((size - 1) * (32768 + sinQ15(angle << 8)) + 32768) >> 16;
+      lissajousError = MAX(lissajousError, abs(position - expected));
+    }
+  }
+  printf("Lissajous positions: max difference %d with sin8 and map\n", lissajousError);
+  return 0;
+}
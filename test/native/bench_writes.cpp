@@ -0,0 +1,105 @@
+/**
+    @title     MoonLight
+    @file      bench_writes.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//frame writes on a 128x64 panel: per light (setLightColor) against the batch writes (setRow, fillStrided, see LightWriter),
+//plain (1:1 mapping), Mirror💎 (x) and serpentine (every other row reversed), times per frame
+//"per light" and "setRow" include making the colors of a row, as an effect does, and must give the same frame (also with setColumn)
+//
+//  make -C test/native bench
+
+#include "MoonLight/Nodes.h"
+#include "bench.h"
+
+PhysicalLayer layerP;
+
+const uint16_t width = 128, height = 64;
+const int runs = 200;
+
+//a width x height panel, serpentine: odd rows from right to left
+class BenchPanelLayout: public LayoutNode {
+public:
+  bool serpentine = false;
+  void addLayout() override {
+    for (int y = 0; y < height; y++)
+      for (int x = 0; x < width; x++)
+        layerV->layerP->addLight({serpentine && y % 2? width - 1 - x: x, y, 0});
+  }
+};
+
+static void mapPanel(bool serpentine, bool mirror) {
+  for (Node *node: layerP.nodes) delete node;
+  layerP.nodes.clear();
+  BenchPanelLayout *panel = new BenchPanelLayout();
+  panel->constructor(layerP.layerV[0], "BenchPanel");
+  panel->hasLayout = true;
+  panel->on = true;
+  panel->serpentine = serpentine;
+  layerP.nodes.push_back(panel);
+  layerP.updateLayerNodes();
+  if (mirror) layerP.addNode("Mirror💎", layerP.nodes.size())->on = true;
+  layerP.layoutPositions.clear(); //run the layout
+  layerP.remap();
+}
+
+static void rowColors(CRGB *colors, uint16_t count, uint16_t y) {
+  for (uint16_t x = 0; x < count; x++) colors[x] = CRGB(x * 2, y * 4, x + y);
+}
+
+static void bench(const char *name, bool serpentine, bool mirror) {
+  mapPanel(serpentine, mirror);
+  VirtualLayer *layer = layerP.layerV[0];
+  uint16_t sizeX = layer->size.x, sizeY = layer->size.y;
+  std::vector<CRGB> colors(sizeX);
+  CRGB *leds = layerP.lights.leds;
+  size_t nrOfChannels = layerP.lights.header.nrOfLights * sizeof(CRGB);
+
+  double perLight = bestMicros(runs, [&]() {
+    for (uint16_t y = 0; y < sizeY; y++) {
+      rowColors(colors.data(), sizeX, y);
+      for (uint16_t x = 0; x < sizeX; x++) layer->setLightColor(x + y * sizeX, colors[x]);
+    }
+    keep(leds[0]);
+  });
+  std::vector<uint8_t> perLightFrame(layerP.lights.channels, layerP.lights.channels + nrOfChannels);
+  memset(layerP.lights.channels, 0, nrOfChannels);
+  double row = bestMicros(runs, [&]() {
+    for (uint16_t y = 0; y < sizeY; y++) {
+      rowColors(colors.data(), sizeX, y);
+      layer->setRow(y, 0, colors.data());
+    }
+    keep(leds[0]);
+  });
+  bool same = memcmp(perLightFrame.data(), layerP.lights.channels, nrOfChannels) == 0;
+  memset(layerP.lights.channels, 0, nrOfChannels);
+  std::vector<CRGB> column(sizeY);
+  for (uint16_t x = 0; x < sizeX; x++) {
+    for (uint16_t y = 0; y < sizeY; y++) column[y] = CRGB(x * 2, y * 4, x + y); //as rowColors
+    layer->setColumn(x, 0, column.data());
+  }
+  same = same && memcmp(perLightFrame.data(), layerP.lights.channels, nrOfChannels) == 0;
+  double perLightBlack = bestMicros(runs, [&]() {
+    for (uint16_t indexV = 0; indexV < layer->nrOfLights; indexV++) layer->setLightColor(indexV, CRGB::Black);
+    keep(leds[0]);
+  });
+  double fill = bestMicros(runs, [&]() {
+    layer->fillStrided(0, CRGB(CRGB::Black), layer->nrOfLights);
+    keep(leds[0]);
+  });
+  printf("%-10s per light %5.1fus  setRow %5.1fus  per light black %5.1fus  fill %5.1fus  %s\n", name, perLight, row, perLightBlack, fill, same? "same frames": "OTHER FRAME");
+}
+
+int main() {
+  printf("%dx%d panel, %d lights\n", width, height, width * height);
+  bench("plain", false, false);
+  bench("Mirror X", false, true);
+  bench("serpentine", true, false);
+  return 0;
+}
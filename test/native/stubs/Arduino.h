@@ -0,0 +1,133 @@
+/**
+    @title     MoonLight
+    @file      Arduino.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of the Arduino / ESP-IDF / FreeRTOS functions used by src/MoonLight, for the tests in test/native only
+//tasks and semaphores are no-ops: the tests run single threaded
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+#include <cstdarg>
+#include <climits>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <new>
+
+typedef uint8_t byte;
+using std::min;
+using std::max;
+
+#define MIN(a,b) ((a)<(b)?(a):(b))
+#define MAX(a,b) ((a)>(b)?(a):(b))
+#define PROGMEM
+#define IRAM_ATTR
+#define PI 3.1415926535897932384626433832795
+#define degrees(rad) ((rad) * 57.29577951308232)
+#define sq(x) ((x)*(x))
+
+#define ESP_LOGD(tag, ...) do {} while (0)
+#define ESP_LOGI(tag, ...) do {} while (0)
+#define ESP_LOGW(tag, ...) do {} while (0)
+#define ESP_LOGE(tag, ...) do {} while (0)
+#define ESP_LOGV(tag, ...) do {} while (0)
+
+inline unsigned long micros() {
+  static auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+inline unsigned long millis() {return micros() / 1000;}
+inline void delay(uint32_t) {}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;}
+inline char *strnstr(const char *haystack, const char *needle, size_t) {return (char *)strstr(haystack, needle);}
+inline size_t strlcpy(char *dst, const char *src, size_t size) {snprintf(dst, size, "%s", src); return strlen(src);}
+inline size_t strlcat(char *dst, const char *src, size_t size) {size_t length = strlen(dst); if (length < size) snprintf(dst + length, size - length, "%s", src); return length + strlen(src);}
+
+struct String {
+  std::string s;
+  String() {}
+  String(const char *c): s(c) {}
+  String(int i): s(std::to_string(i)) {}
+  const char *c_str() const {return s.c_str();}
+  size_t length() const {return s.size();}
+  bool operator==(const char *c) const {return s == c;}
+  bool operator!=(const char *c) const {return s != c;}
+  String operator+(const String &o) const {String r; r.s = s + o.s; return r;}
+  String &operator+=(const String &o) {s += o.s; return *this;}
+};
+
+struct IPAddress {
+  uint8_t bytes[4] = {0};
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d;}
+  uint8_t &operator[](int i) {return bytes[i];}
+  uint8_t operator[](int i) const {return bytes[i];}
+  operator bool() const {return bytes[0];}
+  String toString() const {char buffer[16]; snprintf(buffer, sizeof(buffer), "%d.%d.%d.%d", bytes[0], bytes[1], bytes[2], bytes[3]); return String(buffer);}
+};
+
+//memory
+#define MALLOC_CAP_SPIRAM 1
+#define MALLOC_CAP_8BIT 2
+#define MALLOC_CAP_INTERNAL 4
+inline bool psramFound() {return false;}
+inline void *heap_caps_calloc(size_t count, size_t size, uint32_t) {return calloc(count, size);}
+inline void *heap_caps_realloc(void *pointer, size_t size, uint32_t) {return realloc(pointer, size);}
+inline size_t heap_caps_get_free_size(uint32_t) {return 0;}
+
+struct EspClass {
+  uint32_t getCycleCount() {return micros() * 240;}
+  uint32_t getCpuFreqMHz() {return 240;}
+};
+inline EspClass ESP;
+
+struct Print {
+  size_t print(const char *) {return 0;}
+  size_t println() {return 0;}
+  size_t printf(const char *, ...) {return 0;}
+};
+inline Print Serial;
+
+enum {ESP_MAC_WIFI_STA};
+inline int esp_read_mac(uint8_t *mac, int) {memset(mac, 0x42, 6); return 0;}
+
+//FreeRTOS
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+#define pdMS_TO_TICKS(ms) (ms)
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdTRUE 1
+#define pdFALSE 0
+#define tskIDLE_PRIORITY 0
+#define ARDUINO_RUNNING_CORE 1
+#define ESP32SVELTEKIT_RUNNING_CORE 0
+#define taskYIELD() do {} while (0)
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {return nullptr;}
+inline TickType_t xTaskGetTickCount() {return millis();}
+inline void vTaskDelayUntil(TickType_t *, TickType_t) {}
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *handle, BaseType_t) {*handle = nullptr; return pdFALSE;}
+inline BaseType_t xPortGetCoreID() {return 1;}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) {return 1;}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) {return pdTRUE;}
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {return (SemaphoreHandle_t)1;}
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {return (SemaphoreHandle_t)1;}
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) {return pdTRUE;}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) {return pdTRUE;}
@@ -0,0 +1,52 @@
+/**
+    @title     MoonLight
+    @file      ArduinoJson.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of ArduinoJson for the tests in test/native only: compiles the JSON code of src/MoonLight, stores no values
+//the tests set the members of nodes and modules directly instead of via controls / onUpdate
+
+#pragma once
+
+#include <Arduino.h>
+
+struct JsonVariant {
+  template <class T> JsonVariant &operator=(const T &) {return *this;}
+  JsonVariant operator[](const char *) const {return {};}
+  JsonVariant operator[](int) const {return {};}
+  template <class T> T as() const {return T();}
+  template <class T> T to() const {return T();}
+  template <class T> T add() const {return T();}
+  template <class T> bool add(const T &) {return true;}
+  template <class T> bool is() const {return false;}
+  template <class T> operator T() const {return T();}
+  bool isNull() const {return true;}
+  template <class T> void remove(const T &) {}
+  template <class T> bool operator==(const T &) const {return false;}
+  template <class T> bool operator!=(const T &) const {return true;}
+};
+struct JsonObject: JsonVariant {
+  JsonObject() {}
+  JsonObject(const JsonVariant &) {}
+  using JsonVariant::operator=;
+};
+struct JsonArray: JsonVariant {
+  JsonArray() {}
+  JsonArray(const JsonVariant &) {}
+  using JsonVariant::operator=;
+  JsonObject *begin() {return nullptr;}
+  JsonObject *end() {return nullptr;}
+  size_t size() {return 0;}
+};
+struct JsonDocument: JsonVariant {};
+struct JsonString {
+  const char *c_str() const {return "";}
+  bool isNull() const {return true;}
+};
+template <class T, class S> size_t serializeJson(const T &, S &) {return 0;}
@@ -0,0 +1,43 @@
+/**
+    @title     MoonLight
+    @file      AsyncUDP.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of AsyncUDP for the tests in test/native only
+//writeTo sends to 127.0.0.1 (loopback) on the port asked, so a test can capture the packets, the address asked is kept in sentTo
+
+#pragma once
+
+#include <Arduino.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+extern std::vector<IPAddress> sentTo;
+
+struct AsyncUDPPacket {
+  uint8_t *data() {return nullptr;}
+  size_t length() {return 0;}
+};
+
+struct AsyncUDP {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ~AsyncUDP() {::close(fd);}
+  size_t writeTo(const uint8_t *data, size_t length, const IPAddress &ip, uint16_t port) {
+    sentTo.push_back(ip);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return sendto(fd, data, length, 0, (sockaddr *)&address, sizeof(address)) == (ssize_t)length? length: 0;
+  }
+  bool listen(uint16_t) {return true;}
+  void onPacket(std::function<void(AsyncUDPPacket)>) {}
+  void close() {}
+};
@@ -0,0 +1,43 @@
+/**
+    @title     MoonLight
+    @file      ESPFS.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of the ESP32 file system for the tests in test/native only: files are read and written in ESPFS_ROOT
+
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef ESPFS_ROOT
+  #define ESPFS_ROOT "build/fs"
+#endif
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+struct File {
+  FILE *file = nullptr;
+  File() {}
+  File(FILE *file): file(file) {}
+  operator bool() const {return file;}
+  size_t read(uint8_t *buffer, size_t size) {return fread(buffer, 1, size, file);}
+  size_t write(const uint8_t *buffer, size_t size) {return fwrite(buffer, 1, size, file);}
+  size_t size() {long position = ftell(file); fseek(file, 0, SEEK_END); long size = ftell(file); fseek(file, position, SEEK_SET); return size;}
+  int available() {return size() - ftell(file);}
+  const char *name() {return "";}
+  const char *path() {return "";}
+  void close() {if (file) fclose(file); file = nullptr;}
+};
+
+struct FSClass {
+  File open(const char *path, const char *mode = FILE_READ) {return File(fopen((std::string(ESPFS_ROOT) + path).c_str(), mode[0] == 'w'? "wb": "rb"));}
+  bool remove(const char *path) {return ::remove((std::string(ESPFS_ROOT) + path).c_str()) == 0;}
+};
+inline FSClass ESPFS;
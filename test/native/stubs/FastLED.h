@@ -0,0 +1,92 @@
+/**
+    @title     MoonLight
+    @file      FastLED.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of the FastLED types and functions used by src/MoonLight, for the tests in test/native only
+//color math as FastLED where the tests depend on it (scale8, qadd8, fill_solid), the rest returns black / 0
+
+#pragma once
+
+#include <Arduino.h>
+
+struct CHSV {
+  union {uint8_t h; uint8_t hue;};
+  union {uint8_t s; uint8_t sat;};
+  union {uint8_t v; uint8_t val;};
+  CHSV() {}
+  CHSV(uint8_t h, uint8_t s, uint8_t v): h(h), s(s), v(v) {}
+};
+
+struct CRGB {
+  union {
+    struct {uint8_t r, g, b;};
+    struct {uint8_t red, green, blue;};
+    uint8_t raw[3];
+  };
+  enum HTMLColorCode {Black = 0x000000, White = 0xFFFFFF, Red = 0xFF0000, Green = 0x008000, Blue = 0x0000FF};
+  CRGB() = default;
+  CRGB(uint8_t r, uint8_t g, uint8_t b): r(r), g(g), b(b) {}
+  CRGB(uint32_t code): r(code >> 16), g(code >> 8), b(code) {}
+  CRGB(HTMLColorCode code): CRGB((uint32_t)code) {}
+  CRGB(const CHSV &hsv): r(hsv.h), g(hsv.s), b(hsv.v) {} //not a color conversion
+  uint8_t &operator[](uint8_t i) {return raw[i];}
+  bool operator==(const CRGB &o) const {return r == o.r && g == o.g && b == o.b;}
+  bool operator!=(const CRGB &o) const {return !(*this == o);}
+  CRGB &nscale8(uint8_t scale);
+  CRGB &fadeToBlackBy(uint8_t fade) {return nscale8(255 - fade);}
+  CRGB &operator+=(const CRGB &o);
+};
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) {return ((uint16_t)i * (1 + scale)) >> 8;}
+inline uint8_t qadd8(uint8_t i, uint8_t j) {return MIN(i + j, 255);}
+inline CRGB &CRGB::nscale8(uint8_t scale) {r = scale8(r, scale); g = scale8(g, scale); b = scale8(b, scale); return *this;}
+inline CRGB &CRGB::operator+=(const CRGB &o) {r = qadd8(r, o.r); g = qadd8(g, o.g); b = qadd8(b, o.b); return *this;}
+
+typedef uint32_t TProgmemRGBPalette16[16];
+inline const TProgmemRGBPalette16 PartyColors_p = {0x5500AB, 0x84007C, 0xB5004B, 0xE5001B, 0xE81700, 0xB84700, 0xAB7700, 0xABAB00, 0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E, 0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9};
+inline const TProgmemRGBPalette16 CloudColors_p = {}, LavaColors_p = {}, OceanColors_p = {}, ForestColors_p = {}, RainbowColors_p = {}, RainbowStripeColors_p = {}, HeatColors_p = {}; //only Party has colors
+struct CRGBPalette16 {
+  CRGB entries[16];
+  CRGBPalette16() {}
+  CRGBPalette16(const TProgmemRGBPalette16 &palette) {for (int i = 0; i < 16; i++) entries[i] = CRGB(palette[i]);}
+};
+enum TBlendType {NOBLEND, LINEARBLEND};
+inline CRGB ColorFromPalette(const CRGBPalette16 &palette, uint8_t index, uint8_t brightness = 255, TBlendType = LINEARBLEND) {return CRGB(palette.entries[index >> 4]).nscale8(brightness);}
+
+inline void fill_solid(CRGB *leds, int count, const CRGB &color) {for (int i = 0; i < count; i++) leds[i] = color;}
+inline void fill_rainbow(CRGB *leds, int count, uint8_t hue, uint8_t deltaHue) {for (int i = 0; i < count; i++) leds[i] = CHSV(hue + i * deltaHue, 255, 255);}
+inline void fadeToBlackBy(CRGB *leds, uint16_t count, uint8_t fade) {for (int i = 0; i < count; i++) leds[i].fadeToBlackBy(fade);}
+inline uint8_t sin8(uint8_t) {return 0;}
+inline uint8_t cos8(uint8_t) {return 0;}
+inline uint16_t beat16(uint16_t, uint32_t = 0) {return 0;}
+inline uint16_t beatsin16(uint16_t, uint16_t = 0, uint16_t = 65535, uint32_t = 0, uint16_t = 0) {return 0;}
+inline uint8_t random8() {return rand();}
+inline uint8_t random8(uint8_t lim) {return lim? rand() % lim: 0;}
+inline uint8_t random8(uint8_t min, uint8_t lim) {return min + random8(lim - min);}
+inline uint16_t random16() {return rand();}
+inline uint16_t random16(uint16_t lim) {return lim? rand() % lim: 0;}
+inline uint8_t inoise8(uint16_t, uint16_t, uint16_t) {return 0;}
+
+struct CLEDController {
+  CLEDController &setCorrection(const CRGB &) {return *this;}
+  CLEDController &setLeds(CRGB *, int) {return *this;}
+};
+enum EOrder {RGB, GRB};
+struct WS2812B {};
+struct CFastLED {
+  CLEDController controller;
+  CLEDController &operator[](int) {return controller;}
+  int count() {return 0;}
+  void show() {}
+  void setBrightness(uint8_t) {}
+  void setMaxPowerInMilliWatts(uint32_t) {}
+  template <class CHIPSET, int DATA_PIN, EOrder RGB_ORDER> CLEDController &addLeds(CRGB *, int, int) {return controller;}
+};
+inline CFastLED FastLED;
@@ -0,0 +1,67 @@
+/**
+    @title     MoonBase
+    @file      Module.h
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/moonbase/modules/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//host stub of Module (src/MoonBase/Module.h) for the tests in test/native only: no server, sockets or persistence
+//the Makefile places it next to the copy of src/MoonBase/Utilities.h, so the modules include it as ../MoonBase/Module.h
+
+#ifndef Module_h
+#define Module_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPFS.h>
+#include "Utilities.h"
+
+struct UpdatedItem {
+  const char *parent[2] = {nullptr, nullptr};
+  uint8_t index[2] = {UINT8_MAX, UINT8_MAX};
+  const char *name = nullptr;
+  String oldValue;
+  JsonVariant value;
+};
+
+struct ModuleState {
+  JsonDocument data;
+};
+
+struct EventSocket {
+  int connectedClients = 0;
+  int getConnectedClients() {return connectedClients;}
+  void emitEvent(const char *, JsonObject &) {}
+  void emitEvent(const char *, const char *, size_t) {}
+};
+
+struct PsychicHttpServer;
+struct ESP32SvelteKit;
+struct FilesService;
+
+//the local network is loopback
+struct WiFiClass {
+  IPAddress localIP() {return IPAddress(127, 0, 0, 9);}
+  IPAddress broadcastIP() {return IPAddress(127, 0, 0, 255);}
+};
+static WiFiClass WiFi;
+
+class Module {
+public:
+  Module(String moduleName, PsychicHttpServer *server, ESP32SvelteKit *sveltekit, FilesService *filesService) {}
+  void begin() {}
+  virtual void setupDefinition(JsonArray root) {}
+  virtual void onUpdate(UpdatedItem &updatedItem) {}
+
+protected:
+  ModuleState _state;
+  EventSocket socket;
+  EventSocket *_socket = &socket;
+  FilesService *_filesService = nullptr;
+};
+
+#endif
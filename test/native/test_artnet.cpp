@@ -0,0 +1,221 @@
+/**
+    @title     MoonLight
+    @file      test_artnet.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/moonbase/module/artnet/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//Art-Net, E1.31 and DDP output: ModuleArtnet sends to loopback (stub AsyncUDP), the packets are captured on the protocol ports
+//and compared with packets built from the protocol specifications, independent of ModuleArtnet
+
+#include "MoonLight/Nodes.h"
+
+PhysicalLayer layerP;
+
+#include "MoonLight/ModuleArtnet.h"
+
+std::vector<IPAddress> sentTo;
+
+int failures = 0;
+#define CHECK(condition) do { if (!(condition)) {printf("  FAIL %s (line %d)\n", #condition, __LINE__); failures++;} } while (0)
+
+//a socket receiving what is send to 127.0.0.1:port
+static int capture(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0) {
+    printf("  port %d in use\n", port);
+    exit(1);
+  }
+  int bufferSize = 1 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+  timeval timeout = {0, 200000}; //nothing more send
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+//all packets send since the previous call
+static std::vector<std::vector<uint8_t>> received(int fd) {
+  std::vector<std::vector<uint8_t>> packets;
+  uint8_t buffer[2048];
+  ssize_t length;
+  while ((length = recv(fd, buffer, sizeof(buffer), 0)) > 0) packets.emplace_back(buffer, buffer + length);
+  return packets;
+}
+
+//ANSI E1.31-2018 table 4-1: data packet of a universe
+static std::vector<uint8_t> e131Packet(uint16_t universe, uint8_t priority, uint8_t sequence, const uint8_t *channels, uint16_t size) {
+  uint16_t length = 126 + size;
+  std::vector<uint8_t> packet(length, 0);
+  packet[1] = 0x10; //preamble size
+  memcpy(&packet[4], "ASC-E1.17\0\0\0", 12);
+  packet[16] = 0x70 | (length - 16) >> 8; packet[17] = length - 16;
+  packet[21] = 0x04; //VECTOR_ROOT_E131_DATA
+  memcpy(&packet[22], "MoonLight", 9); //CID: name and mac (stub: 0x42)
+  memset(&packet[32], 0x42, 6);
+  packet[38] = 0x70 | (length - 38) >> 8; packet[39] = length - 38;
+  packet[43] = 0x02; //VECTOR_E131_DATA_PACKET
+  memcpy(&packet[44], "MoonLight", 9); //source name
+  packet[108] = priority;
+  packet[111] = sequence;
+  packet[113] = universe >> 8; packet[114] = universe;
+  packet[115] = 0x70 | (length - 115) >> 8; packet[116] = length - 115;
+  packet[117] = 0x02; //VECTOR_DMP_SET_PROPERTY
+  packet[118] = 0xa1; //address and data type
+  packet[122] = 0x01; //address increment
+  packet[123] = (size + 1) >> 8; packet[124] = size + 1; //start code (0) and channels
+  memcpy(&packet[126], channels, size);
+  return packet;
+}
+
+//Art-Net 4 OpDmx (0x5000), protocol version 14
+static std::vector<uint8_t> artnetPacket(uint16_t universe, uint8_t sequence, const uint8_t *channels, uint16_t size) {
+  std::vector<uint8_t> packet(18 + size, 0);
+  memcpy(&packet[0], "Art-Net", 8);
+  packet[9] = 0x50; packet[11] = 14;
+  packet[12] = sequence;
+  packet[14] = universe; packet[15] = universe >> 8;
+  packet[16] = size >> 8; packet[17] = size;
+  memcpy(&packet[18], channels, size);
+  return packet;
+}
+
+const uint16_t nrOfLights = 4000; //12000 channels: 24 Art-Net / E1.31 universes, 9 DDP packets
+const uint8_t brightness = 128;
+std::vector<uint8_t> scaled; //the channels as send: scaled by the brightness
+
+static void setupLights() {
+  layerP.lights.header.type = ct_Leds;
+  layerP.lights.header.nrOfLights = nrOfLights;
+  layerP.lights.header.channelsPerLight = 3;
+  layerP.lights.header.brightness = brightness;
+  layerP.lights.alloc(nrOfLights * 3);
+  for (size_t i = 0; i < nrOfLights * 3; i++) layerP.lights.channels[i] = i * 7;
+  layerP.lightsOut = new Lights(); //double buffered as in ModuleAnimations::begin, so only changed blocks are marked
+  layerP.copyToLightsOut();
+  scaled.resize(nrOfLights * 3);
+  for (size_t i = 0; i < scaled.size(); i++) scaled[i] = (layerP.lights.channels[i] * brightness) >> 8;
+}
+
+static void testArtnet(ModuleArtnet &artnet, int fd) {
+  printf("Art-Net\n");
+  artnet.protocol = pr_ArtNet;
+  artnet.sync = true;
+  sentTo.clear();
+  artnet.sendFrame();
+  std::vector<std::vector<uint8_t>> packets = received(fd);
+  CHECK(packets.size() == 24 + 1); //ArtSync after the universes
+  size_t wrong = 0;
+  for (size_t universe = 0; universe < 24 && universe < packets.size(); universe++) {
+    uint16_t size = MIN(ARTNET_CHANNELS_PER_PACKET, scaled.size() - universe * ARTNET_CHANNELS_PER_PACKET);
+    if (packets[universe] != artnetPacket(universe, packets[0][12], &scaled[universe * ARTNET_CHANNELS_PER_PACKET], size)) wrong++;
+  }
+  CHECK(wrong == 0);
+  CHECK(packets.back() == std::vector<uint8_t>(ART_SYNC_PACKET, ART_SYNC_PACKET + sizeof(ART_SYNC_PACKET)));
+  CHECK(sentTo.back()[3] == 255); //ArtSync is broadcast
+  printf("  %d packets, %d wrong\n", (int)packets.size(), (int)wrong);
+  artnet.sync = false;
+}
+
+static void testE131(ModuleArtnet &artnet, int fd) {
+  printf("E1.31\n");
+  artnet.protocol = pr_E131;
+  artnet.hardware_outputs_priority = {150};
+  artnet.outputsChanged = true;
+  sentTo.clear();
+  artnet.sendFrame();
+  std::vector<std::vector<uint8_t>> packets = received(fd);
+  CHECK(packets.size() == 24);
+  size_t wrong = 0;
+  for (size_t universe = 0; universe < packets.size(); universe++) {
+    uint16_t size = MIN(ARTNET_CHANNELS_PER_PACKET, scaled.size() - universe * ARTNET_CHANNELS_PER_PACKET);
+    //E1.31 universes start at 1
+    if (packets[universe] != e131Packet(universe + 1, 150, packets[0][111], &scaled[universe * ARTNET_CHANNELS_PER_PACKET], size)) wrong++;
+    if (sentTo[universe][3] != 11) wrong++; //controllerIP
+  }
+  CHECK(wrong == 0);
+  printf("  %d packets, %d wrong\n", (int)packets.size(), (int)wrong);
+
+  //multicast: 239.255.high.low of the universe, next sequence number
+  uint8_t sequence = packets[0][111];
+  artnet.multicast = true;
+  artnet.refresh = true;
+  sentTo.clear();
+  artnet.sendFrame();
+  packets = received(fd);
+  CHECK(packets.size() == 24);
+  wrong = 0;
+  for (size_t universe = 0; universe < packets.size(); universe++) {
+    if (packets[universe][111] != (uint8_t)(sequence + 1)) wrong++;
+    if (sentTo[universe] != IPAddress(239, 255, 0, universe + 1)) wrong++;
+  }
+  CHECK(wrong == 0);
+  artnet.multicast = false;
+}
+
+static void testDDP(ModuleArtnet &artnet, int fd) {
+  printf("DDP\n");
+  artnet.protocol = pr_DDP; //header size 10 instead of 126 and 1440 channels per packet: both must follow
+  artnet.refresh = true;
+  artnet.sendFrame();
+  std::vector<std::vector<uint8_t>> packets = received(fd);
+  CHECK(packets.size() == 9);
+  std::vector<uint8_t> frame(scaled.size());
+  size_t wrong = 0;
+  for (size_t i = 0; i < packets.size(); i++) {
+    const std::vector<uint8_t> &packet = packets[i];
+    uint32_t offset = packet[4] << 24 | packet[5] << 16 | packet[6] << 8 | packet[7];
+    uint16_t length = packet[8] << 8 | packet[9];
+    bool last = i == packets.size() - 1;
+    //version 1, push on the last packet, RGB 8 bits, default output device
+    if (packet.size() != DDP_HEADER_SIZE + length || length > DDP_CHANNELS_PER_PACKET || packet[0] != (last? 0x41: 0x40) || packet[2] != 0x0B || packet[3] != 1 || offset + length > frame.size()) {
+      wrong++;
+      continue;
+    }
+    memcpy(&frame[offset], &packet[DDP_HEADER_SIZE], length);
+  }
+  CHECK(wrong == 0);
+  CHECK(frame == scaled);
+  printf("  %d packets, %d wrong\n", (int)packets.size(), (int)wrong);
+
+  //one light changed: its packet and the last packet (push)
+  layerP.lights.channels[3000] ^= 0xFF;
+  scaled[3000] = (layerP.lights.channels[3000] * brightness) >> 8;
+  layerP.copyToLightsOut();
+  artnet.sendFrame();
+  packets = received(fd);
+  CHECK(packets.size() == 2);
+  if (packets.size() == 2) {
+    CHECK(packets[0][7] == (2 * DDP_CHANNELS_PER_PACKET & 0xFF) && packets[0][0] == 0x40 && packets[0][DDP_HEADER_SIZE + 3000 - 2 * DDP_CHANNELS_PER_PACKET] == scaled[3000]);
+    CHECK(packets[1][0] == 0x41);
+  }
+}
+
+int main() {
+  setupLights();
+  int artnetFd = capture(ARTNET_DEFAULT_PORT), e131Fd = capture(E131_DEFAULT_PORT), ddpFd = capture(DDP_DEFAULT_PORT);
+
+  ModuleArtnet artnet(nullptr, nullptr, nullptr);
+  artnet.fps = 0; //each frame
+  artnet.controllerIP[3] = 11;
+  artnet.hardware_outputs = {nrOfLights};
+  artnet.hardware_outputs_universe_start = {0};
+  artnet.hardware_outputs_priority = {100};
+
+  testArtnet(artnet, artnetFd);
+  testE131(artnet, e131Fd);
+  testDDP(artnet, ddpFd);
+  testArtnet(artnet, artnetFd); //back from DDP
+
+  CHECK(received(artnetFd).empty() && received(e131Fd).empty() && received(ddpFd).empty()); //nothing else send
+
+  printf("%s\n", failures? "FAILED": "passed");
+  return failures? 1: 0;
+}
@@ -0,0 +1,120 @@
+/**
+    @title     MoonLight
+    @file      test_artnetin.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/moonbase/module/artnetin/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//Art-Net, E1.31 and DDP input: frames send by ModuleArtnet to loopback (stub AsyncUDP) are captured and passed to ModuleArtnetIn::receive
+//the lights must be the frame send, complete frames and lost packets must be counted
+
+#include "MoonLight/Nodes.h"
+
+PhysicalLayer layerP;
+
+#include "MoonLight/ModuleArtnetIn.h"
+
+std::vector<IPAddress> sentTo;
+
+int failures = 0;
+#define CHECK(condition) do { if (!(condition)) {printf("  FAIL %s (line %d)\n", #condition, __LINE__); failures++;} } while (0)
+
+//a socket receiving what is send to 127.0.0.1:port
+static int capture(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0) {
+    printf("  port %d in use\n", port);
+    exit(1);
+  }
+  int bufferSize = 1 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+  timeval timeout = {0, 100000}; //nothing more send
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+const uint16_t nrOfLights = 1000; //3000 channels
+
+//send the lights, clear them and receive them back, except packet nr drop; returns the nr of packets
+static int roundTrip(ModuleArtnet &out, ModuleArtnetIn &in, int fd, int drop = -1) {
+  std::vector<uint8_t> frame(layerP.lights.channels, layerP.lights.channels + nrOfLights * 3);
+  out.refresh = true;
+  out.sendFrame();
+  memset(layerP.lights.channels, 0, frame.size());
+  uint8_t buffer[2048];
+  ssize_t length;
+  int packets = 0;
+  while ((length = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    if (packets++ != drop) in.receive(buffer, length);
+  }
+  size_t wrong = 0;
+  for (size_t i = 0; i < frame.size(); i++)
+    if (layerP.lights.channels[i] != (frame[i] * 255) >> 8) wrong++; //as send: scaled by the brightness
+  if (drop < 0) CHECK(wrong == 0);
+  memcpy(layerP.lights.channels, frame.data(), frame.size());
+  return packets;
+}
+
+int main() {
+  layerP.lights.header.type = ct_Leds;
+  layerP.lights.header.nrOfLights = nrOfLights;
+  layerP.lights.header.channelsPerLight = 3;
+  layerP.lights.header.brightness = 255;
+  layerP.lights.alloc(nrOfLights * 3);
+  for (size_t i = 0; i < nrOfLights * 3; i++) layerP.lights.channels[i] = i * 7 + 1;
+  int fds[3] = {capture(ARTNET_DEFAULT_PORT), capture(E131_DEFAULT_PORT), capture(DDP_DEFAULT_PORT)};
+
+  ModuleArtnet out(nullptr, nullptr, nullptr);
+  out.fps = 0;
+  out.controllerIP[3] = 11;
+  out.hardware_outputs = {nrOfLights};
+  out.hardware_outputs_universe_start = {0};
+  out.hardware_outputs_priority = {100};
+
+  ModuleArtnetIn in(nullptr, nullptr, nullptr);
+  in.on = true;
+
+  const char *names[3] = {"Art-Net", "E1.31", "DDP"};
+  for (int protocol = pr_ArtNet; protocol <= pr_DDP; protocol++) {
+    printf("%s\n", names[protocol]);
+    out.protocol = (OutputProtocol)protocol;
+    out.sync = protocol == pr_ArtNet;
+    in.protocol = (OutputProtocol)protocol;
+    in.listen(); //resets the receive state in the next receive
+    in.framesReceived = in.lost = 0;
+    int packets = roundTrip(out, in, fds[protocol]);
+    roundTrip(out, in, fds[protocol], 1); //packet 1 lost
+    roundTrip(out, in, fds[protocol]);
+    printf("  %d packets per frame, %d frames, %d lost\n", packets, (int)in.framesReceived, (int)in.lost);
+    CHECK(in.framesReceived == 3 && in.lost == 1);
+  }
+
+  //a new universe resets the sequence numbers: no packets counted lost
+  printf("universe change\n");
+  in.framesReceived = in.lost = 0;
+  UpdatedItem updatedItem;
+  updatedItem.name = "universe"; //value 0 (the stub ArduinoJson has no values)
+  in.onUpdate(updatedItem);
+  CHECK(in.resetPending);
+  roundTrip(out, in, fds[pr_DDP]);
+  CHECK(!in.resetPending && in.framesReceived == 1 && in.lost == 0);
+
+  //a new universe size is applied by receive, not while it is receiving
+  printf("universe size change\n");
+  updatedItem.name = "universeSize"; //value 0: 1 channel per universe
+  in.onUpdate(updatedItem);
+  CHECK(in.resetPending && in.receiveUniverseSize == ARTNET_CHANNELS_PER_PACKET);
+  roundTrip(out, in, fds[pr_DDP]); //DDP has no universes
+  CHECK(!in.resetPending && in.receiveUniverseSize == 1);
+
+  printf("%s\n", failures? "FAILED": "passed");
+  return failures? 1: 0;
+}
@@ -0,0 +1,236 @@
+/**
+    @title     MoonLight
+    @file      test_mapping.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//mapping tables: a panel through the Mirror and Multiply modifiers, compact (PhysMap) and wide (PhysMapWide, > 16384 lights)
+//each virtual light gets its own color, each physical light must show the color of the virtual light it is mapped to
+
+#include "MoonLight/Nodes.h"
+
+PhysicalLayer layerP;
+
+int failures = 0;
+#define CHECK(condition) do { if (!(condition)) {printf("  FAIL %s (line %d)\n", #condition, __LINE__); failures++;} } while (0)
+
+//a width x height panel, lights row by row
+class TestPanelLayout: public LayoutNode {
+public:
+  uint16_t width, height;
+  void addLayout() override {
+    for (int y = 0; y < height; y++)
+      for (int x = 0; x < width; x++)
+        layerV->layerP->addLight({x, y, 0});
+  }
+};
+
+//as ModuleAnimations::onUpdate: create the node in the node type table and switch it on
+static Node *addNode(const char *animation) {
+  Node *node = layerP.addNode(animation, layerP.nodes.size());
+  node->on = true;
+  return node;
+}
+
+static CRGB colorOf(uint16_t indexV) {return CRGB(indexV & 0xFF, indexV >> 8, 7);}
+
+//map a width x height panel with or without Mirror (x) and Multiply (2x2)
+static void mapPanel(uint16_t width, uint16_t height, bool modifiers) {
+  printf("%dx%d panel (%d lights)%s\n", width, height, width * height, modifiers? " Mirror + Multiply": "");
+  VirtualLayer *layer = layerP.layerV[0];
+
+  TestPanelLayout *panel = new TestPanelLayout();
+  panel->constructor(layer, "TestPanel");
+  panel->hasLayout = true;
+  panel->on = true;
+  panel->width = width;
+  panel->height = height;
+  layerP.nodes = {panel};
+  layerP.updateLayerNodes();
+  if (modifiers) {
+    CHECK(addNode("Mirror💎")->hasModifier); //set by the kind in the node type table
+    CHECK(addNode("Multiply💎")->hasModifier);
+  }
+  layerP.layoutPositions.clear(); //run the layout
+  layerP.remap();
+}
+
+//check the mapping of mapPanel: every physical light
+static void checkPanel(uint16_t width, uint16_t height, bool modifiers) {
+  VirtualLayer *layer = layerP.layerV[0];
+
+  //expected virtual size and virtual light of each physical light, independent of the modifiers
+  uint16_t sizeX = modifiers? (width + 1) / 2 / 2: width;
+  uint16_t sizeY = modifiers? height / 2: height;
+  uint16_t lightsPerRow = modifiers? 8: 1; //2 (mirror) * 2x2 (multiply)
+  auto expectedIndexV = [&](int x, int y) {
+    if (!modifiers) return x + y * width;
+    int mirrored = x >= (width + 1) / 2? width - 1 - x: x;
+    return mirrored % sizeX + (y % sizeY) * sizeX;
+  };
+
+  CHECK(layerP.lights.header.nrOfLights == width * height);
+  CHECK(layer->wideMapping == (width * height > PHYSMAP_MAX_LIGHTS));
+  CHECK(layer->size.x == sizeX && layer->size.y == sizeY);
+  CHECK(layer->nrOfLights == sizeX * sizeY);
+
+  if (modifiers) {
+    //compressed sparse rows: one row per virtual light, lightsPerRow physical lights each, all physical lights once
+    CHECK(layer->mappingTableIndexesSizeUsed == sizeX * sizeY);
+    CHECK(layer->mappingTableOffsets.size() == layer->mappingTableIndexesSizeUsed + 1u);
+    CHECK(layer->mappingTableOffsets.back() == layer->mappingTableIndexes.size());
+    CHECK(layer->mappingTableIndexes.size() == (size_t)width * height);
+    size_t badRows = 0;
+    for (size_t row = 0; row < layer->mappingTableIndexesSizeUsed; row++)
+      if (layer->mappingTableOffsets[row + 1] - layer->mappingTableOffsets[row] != lightsPerRow) badRows++;
+    CHECK(badRows == 0);
+    std::vector<bool> seen(width * height, false);
+    size_t duplicates = 0;
+    for (uint16_t indexP: layer->mappingTableIndexes) {
+      if (seen[indexP]) duplicates++;
+      seen[indexP] = true;
+    }
+    CHECK(duplicates == 0);
+  }
+
+  //write each virtual light, read each physical light
+  memset(layerP.lights.channels, 0, layerP.lights.maxChannels);
+  for (uint16_t indexV = 0; indexV < layer->nrOfLights; indexV++)
+    layer->setLightColor(indexV, colorOf(indexV));
+  size_t wrong = 0, wrongRead = 0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint16_t indexV = expectedIndexV(x, y);
+      if (layerP.lights.leds[x + y * width] != colorOf(indexV)) wrong++;
+      if (layer->getLightColor(indexV) != colorOf(indexV)) wrongRead++;
+    }
+  }
+  CHECK(wrong == 0);
+  CHECK(wrongRead == 0);
+  printf("  virtual %dx%d, %s mapping, %d wrong physical lights\n", layer->size.x, layer->size.y, layer->wideMapping? "wide": "compact", (int)wrong);
+}
+
+//delete the nodes of mapPanel, as PhysicalLayer::removeNode
+static void deleteNodes() {
+  std::vector<Node *> nodes = layerP.nodes;
+  layerP.nodes.clear();
+  layerP.updateLayerNodes();
+  for (Node *node: nodes) delete node;
+}
+
+static void testPanel(uint16_t width, uint16_t height, bool modifiers) {
+  mapPanel(width, height, modifiers);
+  checkPanel(width, height, modifiers);
+  deleteNodes();
+}
+
+//rewrite the mapping cache file with its first size bytes, the last uint16_t replaced by value if given
+static void corruptCache(size_t size, int value = -1) {
+  std::string path = std::string(ESPFS_ROOT) + MAPPING_CACHE_FILE;
+  FILE *file = fopen(path.c_str(), "rb");
+  std::vector<uint8_t> data(size);
+  size = fread(data.data(), 1, size, file);
+  fclose(file);
+  data.resize(size);
+  if (value >= 0) memcpy(&data[size - sizeof(uint16_t)], &value, sizeof(uint16_t));
+  file = fopen(path.c_str(), "wb");
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+}
+
+//overwrite a 32 bits value at offset or append it bytes to the cache file (offset < 0)
+static void patchCache(long offset, int32_t value) {
+  std::string path = std::string(ESPFS_ROOT) + MAPPING_CACHE_FILE;
+  FILE *file = fopen(path.c_str(), offset < 0? "ab": "r+b");
+  if (offset >= 0) fseek(file, offset, SEEK_SET);
+  fwrite(&value, sizeof(value), 1, file);
+  fclose(file);
+}
+
+//a cached mapping is used only if it matches the key and the physical lights, see ModuleAnimations::begin
+static void testCache(uint16_t width, uint16_t height) {
+  mapPanel(width, height, true);
+  CHECK(layerP.saveMapping(1));
+  std::string path = std::string(ESPFS_ROOT) + MAPPING_CACHE_FILE;
+  FILE *file = fopen(path.c_str(), "rb");
+  fseek(file, 0, SEEK_END);
+  size_t size = ftell(file);
+  fclose(file);
+  VirtualLayer *layer = layerP.layerV[0];
+  //bytes from the last index to the end of the file: the index, the offsets and their size
+  size_t offsetsBytes = layer->mappingTableOffsets.size() * sizeof(uint16_t) + sizeof(uint32_t);
+
+  printf("  cache of %d bytes\n", (int)size);
+  CHECK(layerP.loadMapping(1));
+  checkPanel(width, height, true);
+  CHECK(!layerP.loadMapping(2)); //other layout or modifiers
+
+  CHECK(layerP.saveMapping(1));
+  corruptCache(size - offsetsBytes, width * height); //last index refers to a non existing light, offsets missing
+  CHECK(!layerP.loadMapping(1));
+
+  layerP.remap(); //as ModuleAnimations::begin after a failed load
+  CHECK(layerP.saveMapping(1));
+  corruptCache(size, 0xFFFF); //last offset beyond the indexes
+  CHECK(!layerP.loadMapping(1));
+
+  layerP.remap();
+  CHECK(layerP.saveMapping(1));
+  patchCache(8, 0); //size.x of the header (after version and key) is 0
+  CHECK(!layerP.loadMapping(1));
+
+  layerP.remap();
+  CHECK(layerP.saveMapping(1));
+  patchCache(8, width / 2); //positions outside the size
+  CHECK(!layerP.loadMapping(1));
+
+  layerP.remap();
+  CHECK(layerP.saveMapping(1));
+  patchCache(-1, 0); //trailing bytes: the counts do not match the file length
+  CHECK(!layerP.loadMapping(1));
+
+  layerP.remap();
+  CHECK(layerP.saveMapping(1));
+  corruptCache(size / 2); //truncated
+  CHECK(!layerP.loadMapping(1));
+  CHECK(layer->mappingTableSizeUsed == 0 && layerP.layoutPositions.empty()); //left for remap
+
+  layerP.remap();
+  checkPanel(width, height, true);
+  deleteNodes();
+}
+
+//a layout which stops between addLayoutPre and addLayoutPost (e.g. a live script with an error) must not stop the effects
+static void testOpenPass() {
+  printf("pass not closed by the layout\n");
+  mapPanel(16, 16, false);
+  for (layerP.pass = 1; layerP.pass <= 2; layerP.pass++) {
+    layerP.mapPass([]() {
+      layerP.addLayoutPre();
+      for (int x = 0; x < 8; x++) layerP.addLight({x, 0, 0});
+    });
+  }
+  CHECK(!layerP.passOpen);
+  CHECK(layerP.lights.header.type == ct_Leds);
+  CHECK(layerP.lights.header.nrOfLights == 8 && layerP.layerV[0]->nrOfLights == 8);
+  deleteNodes();
+}
+
+int main() {
+  testPanel(128, 64, false); //8192 lights, compact
+  testPanel(128, 64, true);
+  testPanel(256, 160, false); //40960 lights, wide
+  testPanel(256, 160, true);
+  testPanel(400, 160, true); //64000 lights
+  testCache(128, 64);
+  testCache(256, 160);
+  testOpenPass();
+
+  printf("%s\n", failures? "FAILED": "passed");
+  return failures? 1: 0;
+}
@@ -0,0 +1,83 @@
+/**
+    @title     MoonLight
+    @file      test_nodes.cpp
+    @repo      https://github.com/MoonModules/MoonLight, submit changes to this file as PRs
+    @Authors   https://github.com/MoonModules/MoonLight/commits/main
+    @Doc       https://moonmodules.org/MoonLight/general/utilities/
+    @Copyright © 2025 Github MoonLight Commit Authors
+    @license   GNU GENERAL PUBLIC LICENSE Version 3, 29 June 2007
+    @license   For non GPL-v3 usage, commercial licenses must be purchased. Contact moonmodules@icloud.com
+**/
+
+//switching nodes: each node type is created, run and deleted many times (as PhysicalLayer::addNode and removeNode),
+//the heap in use (glibc mallinfo2) must be the same before and after
+
+#include "MoonLight/Nodes.h"
+
+#include <malloc.h>
+
+PhysicalLayer layerP;
+
+int failures = 0;
+#define CHECK(condition) do { if (!(condition)) {printf("  FAIL %s (line %d)\n", #condition, __LINE__); failures++;} } while (0)
+
+//create the node after the layout, run one frame and delete it
+static void switchNode(const char *animation) {
+  Node *node = layerP.addNode(animation, layerP.nodes.size());
+  node->on = true;
+  layerP.loop(); //e.g. palette tables are allocated in the first loop
+  layerP.nodes.pop_back(); //as ModuleAnimations::onUpdate: removed from nodes first
+  layerP.removeNode(node);
+}
+
+//a second layer renders in its own buffer, which is freed and not composed when its effect is switched off or removed
+static void testLayers() {
+  printf("layers\n");
+  Node *bottom = layerP.addNode("Solid🔥", layerP.nodes.size(), 0);
+  bottom->on = true;
+  Node *top = layerP.addNode("Random🔥", layerP.nodes.size(), 1); //adds layer 1
+  top->on = true;
+  VirtualLayer *layer = layerP.layerV[1];
+  layerP.loop();
+  CHECK(layer->layerChannels != nullptr);
+
+  size_t nrOfChannels = layerP.lights.header.nrOfLights * layerP.lights.header.channelsPerLight;
+  top->on = false;
+  layerP.loop();
+  CHECK(layer->layerChannels == nullptr); //freed
+  CHECK(memcmp(layerP.lights.channels, layerP.layerV[0]->layerChannels, nrOfChannels) == 0); //only the bottom layer
+
+  top->on = true;
+  layerP.loop();
+  CHECK(layer->layerChannels != nullptr);
+  layerP.nodes.pop_back();
+  layerP.removeNode(top);
+  layerP.loop();
+  CHECK(layer->layerChannels == nullptr && layer->nodes.empty());
+  CHECK(memcmp(layerP.lights.channels, layerP.layerV[0]->layerChannels, nrOfChannels) == 0);
+
+  layerP.nodes.pop_back();
+  layerP.removeNode(bottom);
+}
+
+int main() {
+  Node *layout = layerP.addNode("Panel🚥", 0); //16x16
+  layout->on = true;
+  layerP.remap();
+
+  for (size_t i = 0; i < nrOfNodeTypes; i++) {
+    if (nodeTypes[i].kind == nk_layout) continue; //the mapping keeps its buffers
+    const char *animation = nodeTypes[i].animation;
+    for (int cycle = 0; cycle < 10; cycle++) switchNode(animation); //node pool and one time allocations
+    size_t inUse = mallinfo2().uordblks;
+    for (int cycle = 0; cycle < 1000; cycle++) switchNode(animation);
+    long leaked = (long)mallinfo2().uordblks - (long)inUse;
+    if (leaked) printf("%s: %ld bytes per switch\n", animation, leaked / 1000);
+    CHECK(leaked == 0);
+  }
+
+  testLayers();
+
+  printf("%s\n", failures? "FAILED": "passed");
+  return failures? 1: 0;
+}